@@ -1,7 +1,9 @@
 #ifndef BITBOARD_H
 #define BITBOARD_H
 
-#include "MagicMoves.hpp"
+#include "sliders.hpp"
+#include <array>
+#include <bit>
 #include <string>
 #include <bitset>
 
@@ -25,12 +27,16 @@ extern const Bitboard Rank6;
 extern const Bitboard Rank7;
 extern const Bitboard Rank8;
 
-extern Bitboard pawnAttacks[2][64];
-extern Bitboard pawnFrontSpan[2][64];
-extern Bitboard knightAttacks[64];
-extern Bitboard kingAttacks[64];
-extern Bitboard betweenBB[64][64];
-extern Bitboard lineBB[64][64];
+// Holds a bitboard for each square. The tables below are built at compile time
+// into read-only data.
+typedef std::array<Bitboard, 64> SquareTable;
+
+extern const std::array<SquareTable, 2> pawnAttacks;
+extern const std::array<SquareTable, 2> pawnFrontSpan;
+extern const SquareTable knightAttacks;
+extern const SquareTable kingAttacks;
+extern const std::array<SquareTable, 64> betweenBB;
+extern const std::array<SquareTable, 64> lineBB;
 
 // Holds mapping from square number to corresponding bitboard.
 extern const Bitboard sqToBB[64];
@@ -57,7 +63,9 @@ enum Piece {
     PIECE_NONE
 };
 
-extern const int PieceVals[6];
+constexpr int PieceVals[6] = {
+    100, 300, 325, 500, 900, 20000
+};
 
 
 enum Color {
@@ -78,20 +86,40 @@ enum Direction {
 };
 
 
-// Initialize key bitboard constants
-void initBitboards();
+// Returns whether the CPU supports the bit instructions the engine was built
+// with (see BITOPS in the Makefile)
+bool bitopsSupported();
+
+// Returns the name of the bit instructions the engine was built with
+const char* bitopsName();
+
+
+// Returns the least significant bit of the bitboard, which must not be empty.
+// Compiles to tzcnt when built with -mbmi and bsf otherwise.
+constexpr Square lsb(Bitboard b) {
+    return (Square)std::countr_zero(b);
+}
+
 
-// Returns the least significant bit of the bitboard
-Square lsb(Bitboard b); 
+// Returns the most significant bit of the bitboard, which must not be empty
+constexpr Square msb(Bitboard b) {
+    return (Square)(63 - std::countl_zero(b));
+}
 
-// Returns the most significant bit of the bitboard
-Square msb(Bitboard b);
 
 // Pops and returns the least significant bit of the bitboard
-Square pop_lsb(Bitboard* b);
+constexpr Square pop_lsb(Bitboard* b) {
+    Square b_lsb = lsb(*b);
+    *b &= *b - 1;
+    return b_lsb;
+}
 
-// returns the number of set bits in the bitboard
-int popcount(Bitboard b);
+
+// Returns the number of set bits in the bitboard. Compiles to popcnt when
+// built with -mpopcnt and to a branchless bit count otherwise.
+constexpr int popcount(Bitboard b) {
+    return std::popcount(b);
+}
 
 
 // Shifts the bitboard in a given direction
@@ -109,6 +137,38 @@ constexpr Bitboard shift(Bitboard b) {
 }
 
 
+// Returns the bitboard with every set bit filled towards the eighth rank
+constexpr Bitboard northFill(Bitboard b) {
+    b |= b << 8;
+    b |= b << 16;
+    b |= b << 32;
+    return b;
+}
+
+
+// Returns the bitboard with every set bit filled towards the first rank
+constexpr Bitboard southFill(Bitboard b) {
+    b |= b >> 8;
+    b |= b >> 16;
+    b |= b >> 32;
+    return b;
+}
+
+
+// Returns every square of the files that hold a set bit
+constexpr Bitboard fileFill(Bitboard b) {
+    return northFill(b) | southFill(b);
+}
+
+
+// Returns the squares in front of the given squares from the color's view, on
+// the same files
+template<Color C>
+constexpr Bitboard frontSpanBB(Bitboard b) {
+    return (C == nWhite ? northFill(b << 8) : southFill(b >> 8));
+}
+
+
 // returns the pawn attacks for a bitboard of pawns and color
 template<Color C>
 constexpr Bitboard pawnAttacksBB(Bitboard pawns) {
@@ -120,9 +180,10 @@ constexpr Bitboard pawnAttacksBB(Bitboard pawns) {
 // Returns the sliding piece attacks for given piece from a square, given
 // occupied squares
 template<Piece P>
-constexpr Bitboard slidingAttacksBB(int sq, Bitboard occupied) {
-    return (P == nBishop ? Bmagic(sq, occupied) : (P == nRook ? Rmagic(sq, occupied) :
-           (P == nQueen ? Bmagic(sq, occupied) | Rmagic(sq, occupied) : 0)));
+inline Bitboard slidingAttacksBB(int sq, Bitboard occupied) {
+    return (P == nBishop ? bishopAttacks(sq, occupied) : (P == nRook ?
+           rookAttacks(sq, occupied) : (P == nQueen ? bishopAttacks(sq, occupied) |
+           rookAttacks(sq, occupied) : 0)));
 }
 
 
@@ -3,17 +3,14 @@
 
 #include <iostream>
 #include <vector>
-#include <stack>
 #include <sstream>
 #include <cassert>
 #include <algorithm>
 #include "bitboard.hpp"
 #include "move.hpp"
+#include "pawnhash.hpp"
 
-const int SEARCH_DEPTH = 6;
-enum TABLE_SIZE {TABLE_SIZE = 100000};
-
-const short pieceTable[6][64] = {
+constexpr short pieceTable[6][64] = {
     // pawn
     {
         0,  0,  0,  0,  0,  0,  0,  0,
@@ -83,7 +80,7 @@ const short pieceTable[6][64] = {
 };
 
 // piece square table courtesy of chess programming wikispace
-const short kingTableEndgame[] =
+constexpr short kingTableEndgame[] =
 {
     -50,-40,-30,-20,-20,-30,-40,-50,
     -30,-20,-10,  0,  0,-10,-20,-30,
@@ -117,39 +114,78 @@ const int safetyTable[100] = {
 
 
 
-enum HashType {
-    HASH_EXACT,
-    HASH_ALPHA,
-    HASH_BETA,
-    HASH_NULL
+// Holds the squares attacked by each piece type of both colors, found once per
+// evaluation for the terms that need them
+struct AttackInfo {
+    // Holds the squares attacked by the pieces of each color and type
+    Bitboard attacks[2][6];
+    // Holds the squares around each color's king and the two in front of it
+    Bitboard kingZone[2];
+    // Holds the mobility score of each color's pieces
+    int mobility[2];
+    // Holds the attacks on each color's king zone, weighted by attacker
+    int kingAttacks[2];
 };
 
-struct HashEntry {
-    unsigned long long zobrist;
-    int depth;
-    int score;
-    bool ancient;
-    HashType nodeType;
-    Move move;
-
-    HashEntry(unsigned long long zobrist, int depth, int score, bool ancient,
-            HashType nodeType, Move move) {
-        this->zobrist = zobrist;
-        this->depth = depth;
-        this->score = score;
-        this->ancient = ancient;
-        this->nodeType = nodeType;
-        this->move = move;
+// Returns a hash of all the Zobrist keys, which identifies the key set
+unsigned long long zobristSignature();
+
+// Holds a midgame and an endgame score, which the evaluation blends by phase
+struct PhaseScore {
+    int mid;
+    int end;
+
+    constexpr PhaseScore operator+(PhaseScore other) const {
+        return {mid + other.mid, end + other.end};
     }
 
-    HashEntry() {
-        this->zobrist = 0;
-        this->depth = 0;
-        this->score = 0;
-        this->ancient=true;
-        this->nodeType=HASH_NULL;
-        this->move = Move();
+    constexpr PhaseScore operator-(PhaseScore other) const {
+        return {mid - other.mid, end - other.end};
     }
+
+    constexpr PhaseScore& operator+=(PhaseScore other) {
+        mid += other.mid;
+        end += other.end;
+        return *this;
+    }
+
+    constexpr PhaseScore& operator-=(PhaseScore other) {
+        mid -= other.mid;
+        end -= other.end;
+        return *this;
+    }
+
+    constexpr bool operator==(const PhaseScore& other) const = default;
+};
+
+// Maximum number of states a board's history can hold, which covers the moves
+// of the game so far and of the search
+const int MAX_HISTORY = 2048;
+
+// Holds the part of the board's state that can't be recovered when a move is
+// undone
+struct StateInfo {
+    // Holds the zobrist key
+    unsigned long long zobrist;
+    // Holds the zobrist key of the pawns alone
+    unsigned long long pawnZobrist;
+    // Holds the fifty move counter
+    int fiftyCount;
+    // Holds the castling rights:
+    // white CAN castle kingside
+    // white CAN'T castle queenside
+    // black CAN castle kingside
+    // black CAN castle queenside
+    short castling;
+    // En passant target square
+    Square enPassant;
+    // Holds the piece captured by the move that led here
+    Piece captured;
+    // Holds the material and piece-square score of each color
+    PhaseScore material[2];
+    // Holds the phase weight of the pieces on the board, 1 for each minor
+    // piece, 2 for each rook and 4 for each queen
+    int phaseWeight;
 };
 
 class Board {
@@ -159,29 +195,21 @@ class Board {
     Bitboard emptyBB;
     // Bitboard that is 1 for all the occupied squares
     Bitboard occupiedBB;
-    // En passant target square
-    std::stack<Square> enPassant;
-    // Holds the castling rights:
-    // white CAN castle kingside
-    // white CAN'T castle queenside
-    // black CAN castle kingside
-    // black CAN castle queenside
-    std::stack<short> castling;
+    // Holds the piece on each square, kept in sync with the bitboards
+    Piece board[64];
     // Holds the color of the side to move
     Color toMove;
-    // Holds the fifty move counter
-    std::stack<int> fiftyList;
-    // holds the list of captured pieces
-    std::stack<Piece> capturedList;
     // holds the full move counter
     int fullMove;
-    // holds the zobrist keys
-    std::vector<unsigned long long> zobrist;
-    // holds the transposition table
-    HashEntry transTable[TABLE_SIZE];
+    // Holds the state after each move made, the last being the current one
+    StateInfo history[MAX_HISTORY];
+    // Holds the index of the current state in the history
+    int histPly;
+
+    // Returns the material and piece-square score from white's view, blended
+    // by the game phase
+    int whiteMaterialScore() const;
 public:
-    // Holds the killer moves list
-    Move killerMoves[SEARCH_DEPTH + 1][2];
     // holds the list of moves
     std::vector<Move> moveList;
     /**
@@ -199,6 +227,14 @@ public:
     // Sets the board's Zobrist key to the one for the given position
     void setZobrist();
 
+    // Sets the board's material and phase weight to the ones counted from
+    // scratch
+    void setMaterial();
+
+    // Returns whether the material and phase weight kept by makeMove and
+    // unmakeMove match the ones counted from scratch
+    bool materialMatches() const;
+
     // Sets the board's to the state desribed by the FEN
     void setPosition(std::string FEN);
 
@@ -250,15 +286,21 @@ public:
     // Returns the zobrist hash key
     unsigned long long getZobrist() const;
 
+    // Returns the zobrist hash key of the pawns
+    unsigned long long getPawnZobrist() const;
+
     // Returns the fifty move counter
     int getFiftyCount() const;
 
+    // Returns how many more moves the history can hold
+    int getHistoryRoom() const;
+
     // Returns whether a square is attacked by a given side
     bool attacked(int square, Color side) const;
 
-    // Returns a bitboard holding the pieces attacking the square of the given
-    // color
-    Bitboard getAttackers(Square sq, Color c) const;
+    // Returns whether a square is attacked by a given side when the board has
+    // the given occupancy
+    bool attacked(int square, Color side, Bitboard occupied) const;
 
     // Returns a color's least valuable attacker of a square
     Square lva(Square sq, Color side) const;
@@ -287,15 +329,12 @@ public:
     // Unmakes a null move for the current position
     void unmakeNullMove();
 
+    // Checks if a move from any position is pseudo-legal in this one
+    bool isPseudoLegal(Move m) const;
+
     // Checks if a pseudo-legal move is legal
     bool isLegal(Move m) const;
 
-    // Gets an entry from the transposition table
-    HashEntry getTransTable(int key) const;
-
-    // Updates an entry in the transposition table
-    void setTransTable(int key, HashEntry entry);
-
     // Returns whether this position has been repeated at some point
     bool isRep();
 
@@ -304,26 +343,43 @@ public:
 
     // Prints out the board's current state
     void printBoard() const;
-    // Returns the evaluation of the board's score
-    int boardScore() const;
+    // Returns the evaluation of the board's score, looking the pawns up in the
+    // given pawn table
+    int boardScore(PawnTable& pawnTable) const;
+    // Returns the material and piece-square part of the evaluation, which
+    // makeMove keeps up to date and so costs next to nothing
+    int materialScore() const;
     // Returns an integer representing the game phase
     int boardPhase() const;
     // Returns the amount of material for the given color
     int materialCount(Color c, bool endgame) const;
-    // Returns the number of isp
-    int getIsolatedPawns(Color c) const;
+    // Returns the material and piece-square score of the given color, counted
+    // from scratch
+    PhaseScore countMaterial(Color c) const;
     // Returns the number of isolated pawns of the given color
+    int getIsolatedPawns(Color c) const;
+    // Returns the number of doubled pawns of the given color
     int getDoubledPawns(Color c) const;
     // Returns the number of backward pawns of the given color
     int getBackwardPawns(Color c) const;
-    // Returns whether a square has a candidate passer or not
-    bool isPasser(Square sq) const;
-    // Returns the passed pawn score for the given color
-    int passedScore(Color c) const;
-    // Returns the mobility score for the given color
-    int mobilityScore(Color c) const;
+    // Returns the candidate passers of the given color
+    Bitboard getPassers(Color c) const;
+    // Evaluates the board's pawns into the given pawn table entry
+    void evalPawns(PawnEntry& entry) const;
+    // Returns the pawn table entry for the board's pawns, evaluating them if
+    // the table does not hold them
+    const PawnEntry& pawnEntry(PawnTable& pawnTable) const;
+    // Returns the passed pawn score for the given color and its passers
+    int passedScore(Color c, Bitboard passers) const;
+    // Fills in the attacks of both colors, with the mobility and king zone
+    // attacks they give
+    void getAttackInfo(AttackInfo& info) const;
+    // Adds the attacks of the given color's pieces of the given type to the
+    // attack info
+    template<Color c, Piece p>
+    void addPieceAttacks(AttackInfo& info) const;
     // Returns the king safety score for the given color
-    int safetyScore(Color c) const;
+    int safetyScore(const AttackInfo& info, Color c) const;
 };
 
 #endif // #ifndef BOARD
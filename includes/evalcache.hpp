@@ -0,0 +1,61 @@
+#ifndef EVALCACHE_HPP
+#define EVALCACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Default size of the evaluation cache in megabytes
+const int EVAL_CACHE_DEFAULT_MB = 2;
+
+// Caches static evaluations by Zobrist key, so positions that iterative
+// deepening and transpositions reach again are not evaluated again. The cache
+// is direct mapped: each key has one slot, and a store replaces whatever it
+// held.
+//
+// Each entry is a single atomic word holding the upper 48 bits of the key and
+// the 16 bit score. Threads share the cache without locks through relaxed loads
+// and stores, which are plain moves on x86-64, and a word is always read and
+// written whole.
+class EvalCache {
+    // Holds the entries of the cache, indexed by the low bits of the key
+    std::unique_ptr<std::atomic<unsigned long long>[]> table;
+    // Holds the number of entries minus one, used to index the cache
+    size_t mask;
+public:
+    // Constructs a new cache of the default size
+    EvalCache();
+
+    // Resizes the cache to the largest power of two number of entries that
+    // fits in the given number of megabytes, clearing it
+    void resize(size_t mb);
+
+    // Empties every entry of the cache
+    void clear();
+
+    // Returns the size of the cache in megabytes
+    size_t getSize() const;
+
+    // Returns whether the cache holds the key, and sets score to its
+    // evaluation if it does
+    bool probe(unsigned long long key, int& score) const {
+        unsigned long long entry = table[key & mask].load(
+                std::memory_order_relaxed);
+        if ((entry ^ key) >> 16) {
+            return false;
+        }
+        score = (short)(entry & 0xffff);
+        return true;
+    }
+
+    // Stores the evaluation of the key, replacing the entry in its slot
+    void store(unsigned long long key, int score) {
+        table[key & mask].store((key & ~0xffffULL) | (unsigned short)score,
+                std::memory_order_relaxed);
+    }
+};
+
+// Holds the evaluation cache shared by all search threads
+extern EvalCache evalCache;
+
+#endif /* ifndef EVALCACHE_HPP */
@@ -0,0 +1,27 @@
+#ifndef LARGEPAGES_HPP
+#define LARGEPAGES_HPP
+
+#include <cstddef>
+
+// Size of the large pages requested from the system
+const size_t LARGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+enum PageMode {
+    PAGES_HUGETLB,
+    PAGES_TRANSPARENT,
+    PAGES_NORMAL,
+    PAGES_MAPPED
+};
+
+// Allocates zeroed memory for a large table, backed by 2 MB pages when the
+// system provides them, and sets mode to the kind of pages that were obtained.
+// Throws std::bad_alloc if no memory could be allocated.
+void* largeAlloc(size_t size, PageMode* mode);
+
+// Frees memory of the given size allocated by largeAlloc
+void largeFree(void* mem, size_t size);
+
+// Returns a readable name for the page mode
+const char* pageModeName(PageMode mode);
+
+#endif /* ifndef LARGEPAGES_HPP */
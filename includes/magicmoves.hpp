@@ -6,6 +6,8 @@
  *
  *Usage:
  *You must first initialize the generator with a call to initmagicmoves().
+ *(Altered: with MINIMIZE_MAGIC the databases are built at compile time into
+ *read-only data, and initmagicmoves() does nothing.)
  *Then you can use the following macros for generating move bitboards by
  *giving them a square and an occupancy.  The macro will then "return"
  *the correct move bitboard for that particular square and occupancy. It
@@ -143,10 +145,17 @@ extern const unsigned int magicmoves_r_shift[64];
 		#endif //USE_INLINING
 
 		//extern U64 magicmovesbdb[5248];
-		extern const U64* magicmoves_b_indices[64];
+		extern const U64* const magicmoves_b_indices[64];
 
 		//extern U64 magicmovesrdb[102400];
-		extern const U64* magicmoves_r_indices[64];
+		extern const U64* const magicmoves_r_indices[64];
+
+		//shared-entry layout (added): the magic index picks a one byte
+		//reference to one of the square's distinct move bitboards
+		extern const unsigned char* const magicmoves_b_shared_refs[64];
+		extern const U64* const magicmoves_b_shared_sets[64];
+		extern const unsigned char* const magicmoves_r_shared_refs[64];
+		extern const U64* const magicmoves_r_shared_sets[64];
 
 	#else //Don't Minimize database size
 
@@ -238,6 +247,17 @@ extern const unsigned int magicmoves_r_shift[64];
 	{
 		return BmagicNOMASK(square,occupancy)|RmagicNOMASK(square,occupancy);
 	}
+
+	#ifdef MINIMIZE_MAGIC
+	static MMINLINE U64 BmagicShared(const unsigned int square,const U64 occupancy)
+	{
+		return magicmoves_b_shared_sets[square][magicmoves_b_shared_refs[square][((occupancy&magicmoves_b_mask[square])*magicmoves_b_magics[square])>>magicmoves_b_shift[square]]];
+	}
+	static MMINLINE U64 RmagicShared(const unsigned int square,const U64 occupancy)
+	{
+		return magicmoves_r_shared_sets[square][magicmoves_r_shared_refs[square][((occupancy&magicmoves_r_mask[square])*magicmoves_r_magics[square])>>magicmoves_r_shift[square]]];
+	}
+	#endif //MINIMIZE_MAGIC
 #else //!USE_INLINING
 
 #define Qmagic(square, occupancy) (Bmagic(square,occupancy)|Rmagic(square,occupancy))
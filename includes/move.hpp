@@ -52,4 +52,57 @@ public:
     bool isPromotion() const;
 };
 
+// Maximum number of moves a list can hold, more than any position has
+const int MAX_MOVES = 256;
+
+// Holds a move along with its ordering score
+struct ScoredMove {
+    Move move;
+    int score;
+};
+
+// Holds the moves of a position in fixed-size storage, so that generating and
+// ordering moves never allocates
+class MoveList {
+    // left uninitialized, as only the first count entries are ever read
+    union {
+        ScoredMove moves[MAX_MOVES];
+    };
+    int count;
+public:
+    MoveList() : count(0) {}
+
+    // Adds a move with a score of zero to the end of the list
+    inline void push_back(Move m) {
+        moves[count++] = {m, 0};
+    }
+
+    // Returns the number of moves in the list
+    inline int size() const {
+        return count;
+    }
+
+    // Returns true iff the list holds no moves
+    inline bool empty() const {
+        return count == 0;
+    }
+
+    // Keeps only the first size moves of the list
+    inline void resize(int size) {
+        count = size;
+    }
+
+    inline ScoredMove& operator[](int i) {
+        return moves[i];
+    }
+
+    inline ScoredMove* begin() {
+        return moves;
+    }
+
+    inline ScoredMove* end() {
+        return moves + count;
+    }
+};
+
 #endif
\ No newline at end of file
@@ -4,26 +4,26 @@
 #include "board.hpp"
 #include "move.hpp"
 #include "bitboard.hpp"
-#include <vector>
 #include <algorithm>
 
 using namespace std;
 
 
+// Captures and quiet moves split the legal moves, with push promotions counted
+// as quiet moves
 enum MoveType {
     ALL,
-    EVASIONS, 
     CAPTURES,
     QUIET
 };
 
+// Generates the moves of the given pawns to the target squares. Pawns that are
+// pinned must be passed one at a time with the targets limited to the pin ray.
 template<Color c, MoveType mv>
-void getPawnMoves(vector<Move> &moveList, Board &b, Bitboard targets) {
-    Bitboard pawns = b.getPieces(c, nPawn);
+void getPawnMoves(MoveList &moveList, Board &b, Bitboard pawns, Bitboard targets) {
     Bitboard empty = b.getEmpty();
     Bitboard other = (c == nWhite ? b.getPieces(nBlack) : b.getPieces(nWhite));
     Bitboard fourthRank = (c == nWhite ? Rank4 : Rank5);
-    Square enPassant = b.enPassantTarget();
 
     constexpr Direction up = (c == nWhite ? NORTH : SOUTH);
     constexpr Direction upRight = (c == nWhite ? NORTH_EAST : SOUTH_WEST);
@@ -31,39 +31,19 @@ void getPawnMoves(vector<Move> &moveList, Board &b, Bitboard targets) {
 
     Bitboard singleMoves = shift<up>(pawns) & empty;
     Bitboard doubleMoves = (shift<up>(singleMoves) & fourthRank) & empty;
-    Bitboard attacksLeft = shift<upLeft>(pawns);
-    Bitboard attacksRight = shift<upRight>(pawns);
-
-
-    singleMoves = (mv == EVASIONS ? singleMoves & targets : singleMoves);
-    doubleMoves = (mv == EVASIONS ? doubleMoves & targets : doubleMoves);
-    attacksLeft = (mv == EVASIONS ? attacksLeft & targets : attacksLeft);
-    attacksRight = (mv == EVASIONS ? attacksRight & targets : attacksRight);
-
-    // en passant
-    if (mv != QUIET) {
-        if (enPassant != SQ_NONE) {
-            if (sqToBB[enPassant] & attacksLeft) {
-                moveList.push_back(Move(enPassant - upLeft, enPassant, 5)); 
-            }
-            if (sqToBB[enPassant] & attacksRight) {
-                moveList.push_back(Move(enPassant - upRight, enPassant, 5)); 
-            }
-        }
-    }
+    Bitboard attacksLeft = shift<upLeft>(pawns) & other & targets;
+    Bitboard attacksRight = shift<upRight>(pawns) & other & targets;
 
-    attacksLeft &= other;
-    attacksRight &= other;
+    singleMoves &= targets;
+    doubleMoves &= targets;
 
     // single pawn moves
     if (mv != CAPTURES) {
         while (singleMoves) {
             int index = pop_lsb(&singleMoves);
             if (index >= A8 || index <= H1) { // promotion
-                if (mv != QUIET) {
-                    for (int flag = 8; flag <= 11; flag++) {
-                        moveList.push_back(Move(index - up, index, flag));
-                    }
+                for (int flag = 8; flag <= 11; flag++) {
+                    moveList.push_back(Move(index - up, index, flag));
                 }
             } else {
                 moveList.push_back(Move(index - up, index, 0));
@@ -101,173 +81,184 @@ void getPawnMoves(vector<Move> &moveList, Board &b, Bitboard targets) {
     }
 }
 
-template<Color c, Piece p, MoveType mv>
-void getSlidingMoves(vector<Move> &moveList, Board &b, Bitboard targets) {
+// Generates the legal en passant captures. Since the capture removes two pieces
+// from the same rank, the king's safety is checked on the resulting occupancy,
+// which also covers the captures that resolve or fail to resolve a check.
+template<Color c>
+void getEnPassant(MoveList &moveList, Board &b, Square kingSquare) {
+    Square enPassant = b.enPassantTarget();
+    if (enPassant == SQ_NONE) {
+        return;
+    }
+
+    constexpr Color other = (c == nWhite ? nBlack : nWhite);
+    constexpr Direction up = (c == nWhite ? NORTH : SOUTH);
+    int capturedSq = static_cast<int>(enPassant) - static_cast<int>(up);
+
+    Bitboard bishopsQueens = b.getPieces(other, nBishop) | b.getPieces(other, nQueen);
+    Bitboard rooksQueens = b.getPieces(other, nRook) | b.getPieces(other, nQueen);
+    Bitboard checkers = (knightAttacks[kingSquare] & b.getPieces(other, nKnight)) |
+        (pawnAttacks[c][kingSquare] & b.getPieces(other, nPawn) & ~sqToBB[capturedSq]);
+    if (checkers) {
+        return;
+    }
+
+    Bitboard attackers = pawnAttacks[other][enPassant] & b.getPieces(c, nPawn);
+    while (attackers) {
+        int start = pop_lsb(&attackers);
+        Bitboard occupied = b.getOccupied() ^ sqToBB[start] ^ sqToBB[enPassant] ^
+            sqToBB[capturedSq];
+        if (!(slidingAttacksBB<nBishop>(kingSquare, occupied) & bishopsQueens) &&
+                !(slidingAttacksBB<nRook>(kingSquare, occupied) & rooksQueens)) {
+            moveList.push_back(Move(start, enPassant, 5));
+        }
+    }
+}
+
+// Generates the moves of the bishops, rooks or queens to the target squares,
+// keeping pinned pieces on their pin rays
+template<Color c, Piece p>
+void getSlidingMoves(MoveList &moveList, Board &b, Bitboard targets, Bitboard
+        pinned, Square kingSquare) {
     Bitboard pieces = b.getPieces(c, p);
     Bitboard occupied = b.getOccupied();
-    Bitboard other = (c == nWhite ? b.getPieces(nBlack) : b.getPieces(nWhite));
 
     while (pieces) {
         int square = pop_lsb(&pieces);
-        // automatically finds proper valid moves
-        Bitboard attacks = slidingAttacksBB<p>(square, occupied);
-        attacks = (mv == EVASIONS ? attacks & targets : attacks);
+        Bitboard attacks = slidingAttacksBB<p>(square, occupied) & targets;
+        if (sqToBB[square] & pinned) {
+            attacks &= lineBB[kingSquare][square];
+        }
         while (attacks) {
             int attackSquare = pop_lsb(&attacks);
-            if ((sqToBB[attackSquare] & other) && mv != QUIET) { // other piece there
-                moveList.push_back(Move(square, attackSquare, 4)); 
-            } else if ((sqToBB[attackSquare] & ~occupied) && mv != CAPTURES) { // not a capture
-                moveList.push_back(Move(square, attackSquare, 0)); 
-            }
+            moveList.push_back(Move(square, attackSquare, (sqToBB[attackSquare] &
+                            occupied) ? 4 : 0));
         }
     }
 }
 
-template<Color c, Piece p, MoveType mv>
-void getMoves(vector<Move> &moveList, Board &b, Bitboard targets) {
-    Bitboard pieces = b.getPieces(c, p); 
+// Generates the moves of the knights to the target squares. Pinned knights can
+// never move.
+template<Color c>
+void getKnightMoves(MoveList &moveList, Board &b, Bitboard targets, Bitboard
+        pinned) {
+    Bitboard pieces = b.getPieces(c, nKnight) & ~pinned;
     Bitboard occupied = b.getOccupied();
-    Bitboard other = (c == nWhite ? b.getPieces(nBlack) : b.getPieces(nWhite));
-    
+
     while (pieces) {
         int square = pop_lsb(&pieces);
-        Bitboard attacks;
-        if (p == nKnight) {
-            attacks = knightAttacks[square];
-        } else { // king
-            attacks = kingAttacks[square];
-        }
-
-        attacks = (mv == EVASIONS ? attacks & targets : attacks);
+        Bitboard attacks = knightAttacks[square] & targets;
         while (attacks) {
             int attackSquare = pop_lsb(&attacks);
-            if ((sqToBB[attackSquare] & other) && mv != QUIET) { // other piece there
-                moveList.push_back(Move(square, attackSquare, 4)); 
-            } else if ((sqToBB[attackSquare] & ~occupied) && mv != CAPTURES) { // not a capture
-                moveList.push_back(Move(square, attackSquare, 0)); 
-            }
+            moveList.push_back(Move(square, attackSquare, (sqToBB[attackSquare] &
+                            occupied) ? 4 : 0));
+        }
+    }
+}
+
+// Generates the king moves to target squares that the other side doesn't
+// attack once the king has left its square
+template<Color c>
+void getKingMoves(MoveList &moveList, Board &b, Bitboard targets, Square
+        kingSquare) {
+    constexpr Color other = (c == nWhite ? nBlack : nWhite);
+    Bitboard occupied = b.getOccupied();
+    Bitboard attacks = kingAttacks[kingSquare] & targets;
+    Bitboard withoutKing = occupied ^ sqToBB[kingSquare];
+
+    while (attacks) {
+        int attackSquare = pop_lsb(&attacks);
+        if (!b.attacked(attackSquare, other, withoutKing)) {
+            moveList.push_back(Move(kingSquare, attackSquare, (sqToBB[attackSquare]
+                            & occupied) ? 4 : 0));
         }
     }
 }
 
 template<Color c>
-void getCastleMoves(vector<Move> &moveList, Board &b, bool
+void getCastleMoves(MoveList &moveList, Board &b, bool
         kingSide) {
-    short castling = b.getCastlingRights();      
+    short castling = b.getCastlingRights();
     Square start = (c == nWhite) ? E1 : E8;
     Square end = kingSide ? ((c == nWhite) ? G1 : G8) : ((c == nWhite) ? C1
-            : C8); 
+            : C8);
     Square rookSq = kingSide ? ((c == nWhite) ? H1 : H8) : ((c == nWhite) ? A1
-            : A8); 
+            : A8);
     int step = (kingSide ? WEST : EAST);
 
     Color other = (c == nWhite) ? nBlack : nWhite;
     if ((castling >> (2 * other + kingSide)) & 1) {
+        if (betweenBB[start][rookSq] & b.getOccupied()) {
+            return;
+        }
         for (int i = end; i != start; i+=step) {
             if (b.attacked((Square)i, other)) {
                 return;
             }
         }
-        if (!(betweenBB[start][rookSq] & b.getOccupied())) {
-            moveList.push_back(Move(start, end, 2 + !kingSide));
-        }
+        moveList.push_back(Move(start, end, 2 + !kingSide));
     }
 }
 
-template<Color c>
-inline void getAllEvasions(vector<Move> &moveList, Board& b, Bitboard targets) {
-    getPawnMoves<c, EVASIONS>(moveList, b, targets);
-    getMoves<c, nKnight, EVASIONS>(moveList, b, targets);
-    getSlidingMoves<c, nBishop, EVASIONS>(moveList, b, targets);
-    getSlidingMoves<c, nRook, EVASIONS>(moveList, b, targets);
-    getSlidingMoves<c, nQueen, EVASIONS>(moveList, b, targets);
-}
-
-template<Color c>
-inline void getCaptures(vector<Move> &moveList, Board& b) {
-    getPawnMoves<c, CAPTURES>(moveList, b, 0);
-    getMoves<c, nKnight, CAPTURES>(moveList, b, 0);
-    getMoves<c, nKing, CAPTURES>(moveList, b, 0);
-    getSlidingMoves<c, nBishop, CAPTURES>(moveList, b, 0);
-    getSlidingMoves<c, nRook, CAPTURES>(moveList, b, 0);
-    getSlidingMoves<c, nQueen, CAPTURES>(moveList, b, 0);
-    getSlidingMoves<c, nKing, CAPTURES>(moveList, b, 0);
-}
-
-// get moves to get out of check
-template<Color c>
-void getEvasions(vector<Move> &moveList, Board& b) {
-    Color other = (c == nWhite) ? nBlack : nWhite;
-    Bitboard otherBB = b.getPieces(other);
-
-    // find list of sliding checkers
+// Generates the legal moves of the given type. The checkers and pinned pieces
+// are found once, and every generator only emits moves that keep the king safe.
+template<Color c, MoveType mv>
+void getMoves(MoveList &moveList, Board& b) {
+    constexpr Color other = (c == nWhite ? nBlack : nWhite);
+    Square kingSquare = lsb(b.getPieces(c, nKing));
     Bitboard checkers = b.getCheckers();
-    Bitboard sliders = ~b.getPieces(other, nPawn) & ~b.getPieces(other, nKnight);
-    sliders &= checkers;
-    Bitboard sliderAttacks = 0;
 
-    int kingSquare = lsb(b.getPieces(c, nKing));
+    Bitboard targets = (mv == CAPTURES ? b.getPieces(other) : (mv == QUIET ?
+                b.getEmpty() : ~b.getPieces(c)));
+    getKingMoves<c>(moveList, b, targets, kingSquare);
 
-    while (sliders) {
-        int attackSq = pop_lsb(&sliders);
-        sliderAttacks |= lineBB[attackSq][kingSquare] ^ sqToBB[attackSq];
+    // only the king can escape a double check
+    if (checkers & (checkers - 1)) {
+        return;
     }
 
-    // generate list of king evading moves
-    Bitboard kingMoves = kingAttacks[kingSquare] & ~sliderAttacks;
-    while (kingMoves) {
-        int square = pop_lsb(&kingMoves);
-        if (sqToBB[square] & otherBB) {
-            moveList.push_back(Move(kingSquare, square, 4)); 
-        } else {
-            moveList.push_back(Move(kingSquare, square, 0)); 
-        }
+    // other moves must capture or block a single checker. Pinned pieces can't
+    // do either, as they have to stay on the pin ray.
+    if (checkers) {
+        targets &= betweenBB[lsb(checkers)][kingSquare] | checkers;
     }
 
-    if (b.doubleCheck()) {
-        return;
+    Bitboard sliders = b.getPieces(nBishop) | b.getPieces(nRook) | b.getPieces(nQueen);
+    Bitboard pinned = b.pinnedPieces(sliders & b.getPieces(other), kingSquare) &
+        b.getPieces(c);
+
+    Bitboard pawns = b.getPieces(c, nPawn);
+    getPawnMoves<c, mv>(moveList, b, pawns & ~pinned, targets);
+    Bitboard pinnedPawns = pawns & pinned;
+    while (pinnedPawns) {
+        int square = pop_lsb(&pinnedPawns);
+        getPawnMoves<c, mv>(moveList, b, sqToBB[square], targets &
+                lineBB[kingSquare][square]);
+    }
+    if (mv != QUIET) {
+        getEnPassant<c>(moveList, b, kingSquare);
     }
 
-    // We know there is one checker now.
-    int checkSq = lsb(checkers);
-    Bitboard targets = betweenBB[checkSq][kingSquare] | sqToBB[checkSq];
-    getAllEvasions<c>(moveList, b, targets);
-}
+    getSlidingMoves<c, nBishop>(moveList, b, targets, pinned, kingSquare);
+    getSlidingMoves<c, nRook>(moveList, b, targets, pinned, kingSquare);
+    getSlidingMoves<c, nQueen>(moveList, b, targets, pinned, kingSquare);
+    getKnightMoves<c>(moveList, b, targets, pinned);
 
-template<Color c>
-inline void getPseudoLegalMoves(vector<Move> &moveList, Board& b) {
-    getPawnMoves<c, ALL>(moveList, b, 0);
-    getSlidingMoves<c, nBishop, ALL>(moveList, b, 0);
-    getSlidingMoves<c, nRook, ALL>(moveList, b, 0);
-    getSlidingMoves<c, nQueen, ALL>(moveList, b, 0);
-    getMoves<c, nKnight, ALL>(moveList, b, 0);
-    getMoves<c, nKing, ALL>(moveList, b, 0);
-    getCastleMoves<c>(moveList, b, true);
-    getCastleMoves<c>(moveList, b, false);
+    if (mv != CAPTURES && !checkers) {
+        getCastleMoves<c>(moveList, b, true);
+        getCastleMoves<c>(moveList, b, false);
+    }
 }
 
 template<Color c>
-inline void getAllMoves(vector<Move> &moveList, Board& b) {
-    if (b.inCheck()) {
-        getEvasions<c>(moveList, b);
-    } else {
-        getPseudoLegalMoves<c>(moveList, b);
-    }
+inline void getCaptures(MoveList &moveList, Board& b) {
+    getMoves<c, CAPTURES>(moveList, b);
 }
 
 template<Color c>
-inline void getLegalMoves(vector<Move> &moveList, Board& b) {
-    c == nWhite ? getAllMoves<nWhite>(moveList, b) :
-        getAllMoves<nBlack>(moveList, b);
-    vector<Move>::iterator it = moveList.begin();
-    while (it != moveList.end()) {
-        if (!b.isLegal(*it)) {
-            it = moveList.erase(it);
-        } else {
-            it++;
-        }
-    }
+inline void getLegalMoves(MoveList &moveList, Board& b) {
+    getMoves<c, ALL>(moveList, b);
 }
 
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,58 @@
+#ifndef MOVEPICKER_HPP
+#define MOVEPICKER_HPP
+
+#include "board.hpp"
+#include "move.hpp"
+
+// The stages a move picker goes through, in order
+enum PickerStage {
+    STAGE_TT,
+    STAGE_GEN_CAPTURES,
+    STAGE_GOOD_CAPTURES,
+    STAGE_KILLERS,
+    STAGE_GEN_QUIETS,
+    STAGE_QUIETS,
+    STAGE_BAD_CAPTURES,
+    STAGE_DONE
+};
+
+// Hands out the moves of a position one at a time, best first, generating each
+// group of moves only once it is reached. The table move comes first, then the
+// captures that don't lose material, the killers, the quiet moves and last the
+// captures that do. A cutoff in an early stage saves generating the rest.
+class MovePicker {
+    Board& b;
+    Move ttMove;
+    Move killers[2];
+    int stage;
+    // Holds the stage of the move last handed out
+    int moveStage;
+    int captureIndex;
+    int killerIndex;
+    int quietIndex;
+    int generated;
+    MoveList captures;
+    MoveList quiets;
+
+    // Moves the best scored move at or after the index to the index, and
+    // returns it
+    ScoredMove& pickBest(MoveList& moveList, int index);
+
+    // Returns whether the move is one that was already handed out
+    bool isSpecial(Move m);
+public:
+    // Constructs a picker for the board with the given table move and killers,
+    // both of which are checked before they are handed out
+    MovePicker(Board& b, Move ttMove, const Move* killers);
+
+    // Returns the next legal move, or the null move once there are none left
+    Move next();
+
+    // Returns the stage of the move last handed out
+    int getStage() const;
+
+    // Returns the number of moves generated so far
+    int getGenerated() const;
+};
+
+#endif
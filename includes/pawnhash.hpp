@@ -0,0 +1,59 @@
+#ifndef PAWNHASH_HPP
+#define PAWNHASH_HPP
+
+#include <vector>
+#include "bitboard.hpp"
+
+// Number of entries in a pawn table, 512 kb of them
+const int PAWN_TABLE_SIZE = 16384;
+
+// Holds the evaluation terms that depend only on the pawns. A zeroed entry is
+// the one for a board without pawns, which scores 0 and has no passers.
+struct PawnEntry {
+    // Holds the pawn Zobrist key of the pawns the entry was computed for
+    unsigned long long key;
+    // Holds the candidate passed pawns of each color
+    Bitboard passers[2];
+    // Holds the isolated, backward and doubled pawn score from white's view
+    int score;
+};
+
+// Caches the pawn evaluation by pawn Zobrist key. Pawn structure changes in
+// few of the moves searched, so most positions find their pawns already
+// evaluated. Each search thread has its own table, kept from one search to the
+// next, so it needs no locking.
+class PawnTable {
+    // Holds the entries of the table, indexed by the low bits of the key
+    std::vector<PawnEntry> entries;
+    // Holds the number of probes since the statistics were reset
+    unsigned long long probes;
+    // Holds the number of those probes that found their key
+    unsigned long long hits;
+public:
+    // Constructs an empty table
+    PawnTable();
+
+    // Returns the entry for the key's index, and whether it holds the key.
+    // An entry that does not must be filled in by the caller.
+    PawnEntry& probe(unsigned long long key, bool& found) {
+        PawnEntry& entry = entries[key & (PAWN_TABLE_SIZE - 1)];
+        found = (entry.key == key);
+        probes++;
+        hits += found;
+        return entry;
+    }
+
+    // Returns the number of probes since the statistics were reset
+    unsigned long long getProbes() const;
+
+    // Returns the number of those probes that found their key
+    unsigned long long getHits() const;
+
+    // Sets the probe and hit counts back to zero
+    void resetStats();
+
+    // Empties every entry of the table
+    void clear();
+};
+
+#endif /* ifndef PAWNHASH_HPP */
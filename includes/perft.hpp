@@ -0,0 +1,55 @@
+#ifndef PERFT_HPP
+#define PERFT_HPP
+
+#include <vector>
+#include "board.hpp"
+
+// Holds the leaf counts of subtrees that perft has already walked, so that a
+// position reached again by a transposition is counted only once. Threads can
+// share a table without locks.
+class PerftTable {
+    // Holds an entry as it is stored in the table. The data word holds the
+    // depth in its low 8 bits and the count above them. Like the transposition
+    // table, the first word holds the key XORed with the data word, so that a
+    // torn read is rejected.
+    struct PerftEntry {
+        unsigned long long check;
+        unsigned long long data;
+    };
+
+    std::vector<PerftEntry> table;
+    unsigned long long mask;
+public:
+    // Constructs a table of the given size in MB, rounded down to a power of
+    // two. A size of 0 gives a table that never holds anything.
+    PerftTable(int mb);
+
+    // Returns whether the table holds the count for the position and depth,
+    // storing it in count if so
+    bool probe(unsigned long long key, int depth, unsigned long long& count)
+        const;
+
+    // Stores the count for the position and depth
+    void store(unsigned long long key, int depth, unsigned long long count);
+};
+
+// Returns the number of leaf positions the given depth below the board. The
+// moves at the last ply are counted without being made. The table is used
+// when one is given.
+unsigned long long perft(Board& b, int depth, PerftTable* table = nullptr);
+
+// Returns the number of leaf positions the given depth below the board,
+// counted on the given number of threads, and adds the count below each root
+// move to rootCounts, which is indexed like the legal moves of the board. The
+// subtrees two plies down are dealt out to the threads, each of which walks
+// them on its own copy of the board and takes work from the others once its
+// own runs out. The table, if given, is shared by all the threads.
+unsigned long long parallelPerft(const Board& b, int depth, int threads,
+        PerftTable* table, std::vector<unsigned long long>& rootCounts);
+
+// Runs perft from the board on the given number of threads, printing the count
+// below each root move, the total and the speed. Uses a perft table of the
+// given size in MB, if not 0.
+unsigned long long perftDivide(Board& b, int depth, int hashMB, int threads);
+
+#endif
@@ -4,55 +4,77 @@
 #include <utility>
 #include "board.hpp"
 #include "movegen.hpp"
+#include "movepicker.hpp"
+#include "tt.hpp"
+#include "evalcache.hpp"
 #include <chrono>
+#include <atomic>
 
 extern const int MAX_VALUE;
 extern const int MATE_VALUE;
 
-struct MoveData {
-    Move move;
-    int score;
+// Maximum number of plies a search can reach
+const int MAX_PLY = 64;
 
-    MoveData(int score, Move m) {
-        this->move = m;
-        this->score = score;
-    }
-    
-    MoveData() {
-        this->move = Move();
-        this->score = 0;
-    }
-};
+// Default margin of the lazy evaluation in quiescence search
+const int LAZY_MARGIN_DEFAULT = 400;
+
+// Holds how far the material score must be outside the window for quiescence
+// search to stand pat on it without the full evaluation. Set by the LazyMargin
+// option.
+extern int lazyMargin;
 
 struct SearchInfo {
 	chrono::high_resolution_clock::time_point startTime;
 	chrono::high_resolution_clock::time_point time;
     int depth;
     long duration; // in ms
-    int nodes;
+    unsigned long long nodes;
+    // Holds the number of moves the move pickers generated
+    unsigned long long generated;
+    // Holds the number of beta cutoffs made by a move of each picker stage
+    unsigned long long cutoffs[STAGE_DONE];
+    // Holds the number of stand pat evaluations in quiescence search
+    unsigned long long qEvals;
+    // Holds the number of those that took the material score as good enough
+    unsigned long long lazyEvals;
+    // Holds the number of full evaluations looked up in the evaluation cache
+    unsigned long long cacheProbes;
+    // Holds the number of those found in the cache
+    unsigned long long cacheHits;
     bool infinite;
-    bool stopped;
+    std::atomic<bool> stopped;
 
     SearchInfo() {
         depth = 0;
         duration = 0;
         nodes = 0;
+        generated = 0;
+        std::fill(cutoffs, cutoffs + STAGE_DONE, 0);
+        qEvals = 0;
+        lazyEvals = 0;
+        cacheProbes = 0;
+        cacheHits = 0;
         infinite = false;
         stopped = true;
     }
 };
 
 struct sortMoves {
-    bool operator()(MoveData const &a, MoveData const &b) { 
+    bool operator()(ScoredMove const &a, ScoredMove const &b) { 
             return a.score > b.score;
     }
 };
 
 class Search {
     SearchInfo* info;
+    // Holds the pawn table of the thread running the search
+    PawnTable* pawnTable;
+    // Holds the killer moves list, indexed by ply
+    Move killerMoves[MAX_PLY][2];
 public:
-    // Constructs a new search object
-    Search(SearchInfo* info);
+    // Constructs a new search object that evaluates pawns with the given table
+    Search(SearchInfo* info, PawnTable* pawnTable);
 
     // Holds the best move for the search
     Move bestMove; 
@@ -65,7 +87,24 @@ public:
     // Performs quiescence search on the given board
     int quiesce(Board &b, int alpha, int beta);
 
-    // Orders the moves in the given move list
-    void orderMoves(Board& b, std::vector<Move>& moveList, std::vector<MoveData>& moveScores, int ply);
+    // Scores and sorts the moves in the given move list
+    void orderMoves(Board& b, MoveList& moveList, int ply);
+};
+
+// Holds the state owned by a single helper thread of a parallel search. Each
+// helper searches its own copy of the board with its own killers, and only
+// shares the transposition table with the other threads.
+struct SearchThread {
+    Board board;
+    SearchInfo info;
+    Search search;
+    int completedDepth;
+    int score;
+    Move bestMove;
+
+    SearchThread(const Board& b, const SearchInfo& main, PawnTable* pawnTable);
+
+    // Runs iterative deepening up to the given depth until stopped
+    void run(int max, int id);
 };
 #endif /*SEARCH_HPP*/
\ No newline at end of file
@@ -0,0 +1,190 @@
+#ifndef SLIDERS_HPP
+#define SLIDERS_HPP
+
+#include "magicmoves.hpp"
+#include <array>
+#include <bit>
+
+#ifdef USE_PEXT
+#include <immintrin.h>
+#endif
+
+// Sliding attacks can be looked up by four backends, chosen at build time:
+//
+// magic     the magicmoves multiply and shift lookup, the default
+// shared    the same magic index into one byte references to each square's
+//           distinct attack sets, 155kb of tables instead of 841kb, built
+//           with -DUSE_SHARED (make SLIDERS=shared). The extra dependent load
+//           makes it slower than magic unless the tables are being evicted,
+//           so it is not the default.
+// pext      BMI2 PEXT indexing into tables of 16 bit attack sets, which PDEP
+//           expands again, built with -DUSE_PEXT -mbmi2 (make SLIDERS=pext)
+// portable  ray scans that need no lookup tables or special instructions,
+//           built with -DUSE_PORTABLE (make SLIDERS=portable)
+//
+// The tables of every backend are built at compile time into read-only data,
+// so the benchmark can compare them all whichever one the engine uses.
+
+#ifndef MINIMIZE_MAGIC
+#error "the magic backend needs the compile time databases of MINIMIZE_MAGIC"
+#endif
+
+// Holds what the PEXT backend needs to look up the attacks from one square
+struct PextEntry {
+    // Holds the squares whose occupancy changes the attacks
+    unsigned long long mask;
+    // Holds the attacks on an empty board, which the stored sets are packed in
+    unsigned long long attacks;
+    // Holds the index of the square's first entry in the attack table
+    unsigned int offset;
+};
+
+// Number of entries in the PEXT attack table, 5248 for the bishops and 102400
+// for the rooks
+const int PEXT_TABLE_SIZE = 107648;
+
+extern const std::array<PextEntry, 64> bishopPext;
+extern const std::array<PextEntry, 64> rookPext;
+extern const std::array<unsigned short, PEXT_TABLE_SIZE> pextAttackTable;
+
+// Holds the squares from each square to the edge of the board, in the order
+// north, east, north east, north west, south, west, south west, south east.
+// The first four rays run towards higher squares.
+extern const std::array<std::array<unsigned long long, 64>, 8> rayBB;
+
+// Returns the name of the backend the engine was built with
+const char* sliderBackendName();
+
+// Returns whether the CPU can run the backend the engine was built with
+bool sliderBackendSupported();
+
+// Times each sliding attack backend the CPU can run on random squares and
+// occupancies, and prints their lookups per second, table size and cache
+// misses. With pressure, the given number of megabytes is streamed through
+// between rounds, evicting the tables the way other threads' TT probes do.
+void sliderBench(int lookups, int pressureMB);
+
+
+// Returns the attacks from the square along the given ray, in the order of
+// rayBB, stepping square by square until the first blocker. Only meant for
+// building tables at compile time.
+constexpr unsigned long long slowRayAttacks(int sq, unsigned long long occupied,
+        int dir) {
+    constexpr int fileStep[8] = {0, 1, 1, -1, 0, -1, -1, 1};
+    constexpr int rankStep[8] = {1, 0, 1, 1, -1, 0, -1, -1};
+    unsigned long long attacks = 0;
+    int file = sq % 8 + fileStep[dir];
+    int rank = sq / 8 + rankStep[dir];
+    while (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+        unsigned long long bb = 1ULL << (8 * rank + file);
+        attacks |= bb;
+        if (occupied & bb) {
+            break;
+        }
+        file += fileStep[dir];
+        rank += rankStep[dir];
+    }
+    return attacks;
+}
+
+
+// Returns the bishop attacks from the square using the shared-entry magicmoves
+// tables
+inline unsigned long long sharedBishopAttacks(int sq, unsigned long long
+        occupied) {
+    return BmagicShared(sq, occupied);
+}
+
+
+// Returns the rook attacks from the square using the shared-entry magicmoves
+// tables
+inline unsigned long long sharedRookAttacks(int sq, unsigned long long occupied) {
+    return RmagicShared(sq, occupied);
+}
+
+
+// Returns the bishop attacks from the square using the magicmoves tables
+inline unsigned long long magicBishopAttacks(int sq, unsigned long long occupied) {
+    return Bmagic(sq, occupied);
+}
+
+
+// Returns the rook attacks from the square using the magicmoves tables
+inline unsigned long long magicRookAttacks(int sq, unsigned long long occupied) {
+    return Rmagic(sq, occupied);
+}
+
+
+#ifdef USE_PEXT
+// Returns the attacks from the square stored in the PEXT tables
+inline unsigned long long pextAttacks(const PextEntry& entry, unsigned long long
+        occupied) {
+    return _pdep_u64(pextAttackTable[entry.offset + _pext_u64(occupied,
+                entry.mask)], entry.attacks);
+}
+#endif
+
+
+// Returns the attacks from the square along the rays with the given indices,
+// stopping each ray at its first blocker
+template<int First, int Last>
+inline unsigned long long rayAttacks(int sq, unsigned long long occupied) {
+    unsigned long long attacks = 0;
+    for (int dir = First; dir <= Last; dir++) {
+        unsigned long long ray = rayBB[dir][sq];
+        unsigned long long blockers = ray & occupied;
+        if (blockers) {
+            int blocker = (dir < 4 ? std::countr_zero(blockers) : 63 -
+                    std::countl_zero(blockers));
+            ray ^= rayBB[dir][blocker];
+        }
+        attacks |= ray;
+    }
+    return attacks;
+}
+
+
+// Returns the bishop attacks from the square by scanning its rays
+inline unsigned long long portableBishopAttacks(int sq, unsigned long long
+        occupied) {
+    return rayAttacks<2, 3>(sq, occupied) | rayAttacks<6, 7>(sq, occupied);
+}
+
+
+// Returns the rook attacks from the square by scanning its rays
+inline unsigned long long portableRookAttacks(int sq, unsigned long long
+        occupied) {
+    return rayAttacks<0, 1>(sq, occupied) | rayAttacks<4, 5>(sq, occupied);
+}
+
+
+// Returns the bishop attacks from the square with the backend the engine was
+// built with
+inline unsigned long long bishopAttacks(int sq, unsigned long long occupied) {
+#if defined(USE_PEXT)
+    return pextAttacks(bishopPext[sq], occupied);
+#elif defined(USE_SHARED)
+    return sharedBishopAttacks(sq, occupied);
+#elif defined(USE_PORTABLE)
+    return portableBishopAttacks(sq, occupied);
+#else
+    return magicBishopAttacks(sq, occupied);
+#endif
+}
+
+
+// Returns the rook attacks from the square with the backend the engine was
+// built with
+inline unsigned long long rookAttacks(int sq, unsigned long long occupied) {
+#if defined(USE_PEXT)
+    return pextAttacks(rookPext[sq], occupied);
+#elif defined(USE_SHARED)
+    return sharedRookAttacks(sq, occupied);
+#elif defined(USE_PORTABLE)
+    return portableRookAttacks(sq, occupied);
+#else
+    return magicRookAttacks(sq, occupied);
+#endif
+}
+
+#endif
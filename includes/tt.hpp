@@ -0,0 +1,134 @@
+#ifndef TT_HPP
+#define TT_HPP
+
+#include <cstddef>
+#include <string>
+#include "move.hpp"
+#include "largepages.hpp"
+
+enum HashType {
+    HASH_NULL,
+    HASH_EXACT,
+    HASH_ALPHA,
+    HASH_BETA
+};
+
+// Stored in place of a static evaluation when none was computed
+const int EVAL_NONE = -32768;
+
+// Holds a transposition table entry as seen by the search
+struct HashEntry {
+    int depth;
+    int score;
+    int eval;
+    HashType nodeType;
+    Move move;
+
+    HashEntry(int depth, int score, int eval, HashType nodeType, Move move) {
+        this->depth = depth;
+        this->score = score;
+        this->eval = eval;
+        this->nodeType = nodeType;
+        this->move = move;
+    }
+
+    HashEntry() {
+        this->depth = 0;
+        this->score = 0;
+        this->eval = EVAL_NONE;
+        this->nodeType = HASH_NULL;
+        this->move = Move();
+    }
+};
+
+// Holds an entry as it is stored in the table, packed into 16 bytes. The data
+// word holds, from the lowest bits up, the 16 bit move, the 16 bit score, the
+// 16 bit static evaluation, the 8 bit depth, and 8 bits combining the node
+// type (low 2 bits) with the generation (high 6 bits). A zeroed entry is empty.
+//
+// The table is shared by all search threads without locks, so the first word
+// holds the key XORed with the data word. A read that sees the two words of
+// different writes decodes to a key that does not match and is rejected.
+struct PackedEntry {
+    unsigned long long check;
+    unsigned long long data;
+};
+
+// Number of entries that share one index of the table
+const int BUCKET_SIZE = 4;
+
+// Holds the entries for one index, packed into a single cache line
+struct alignas(64) HashBucket {
+    PackedEntry entries[BUCKET_SIZE];
+};
+
+class TransTable {
+    // Holds the buckets of the table
+    HashBucket* table;
+    // Holds the number of buckets minus one, used to index the table
+    size_t mask;
+    // Holds the kind of pages backing the table
+    PageMode pageMode;
+    // Holds the age of the current search, which wraps around at 64
+    unsigned char generation;
+
+    // Returns the table's memory to the system
+    void release();
+public:
+    // Constructs a new table of the default size
+    TransTable();
+
+    ~TransTable();
+
+    // Resizes the table to the largest power of two number of buckets that
+    // fits in the given number of megabytes, clearing it
+    void resize(size_t mb);
+
+    // Empties every entry of the table
+    void clear();
+
+    // Returns the size of the table in megabytes
+    size_t getSize() const;
+
+    // Returns the kind of pages backing the table
+    PageMode getPageMode() const;
+
+    // Ages the table so entries from previous searches are replaced first
+    void newSearch();
+
+    // Starts loading the bucket of the given key into the cache, so a probe
+    // soon after does not wait on memory. Compiled out with NO_PREFETCH.
+    void prefetch(unsigned long long key) const {
+#ifndef NO_PREFETCH
+        __builtin_prefetch(&table[key & mask]);
+#endif
+    }
+
+    // Returns the entry for the given key, or an empty entry if there is none
+    HashEntry probe(unsigned long long key) const;
+
+    // Stores a search result, replacing the least valuable entry of its bucket
+    void store(unsigned long long key, int depth, int score, int eval, HashType
+            nodeType, Move move);
+
+    // Returns how full the table is with entries of this search, in permill
+    int hashfull() const;
+
+    // Writes the table to the given file, returning whether it succeeded
+    bool save(const std::string& file) const;
+
+    // Replaces the table with one written by save(), returning whether it
+    // succeeded. The file is mapped into memory rather than read, so loading
+    // is instant and entries are paged in as the search uses them.
+    bool load(const std::string& file);
+
+    // Stores to and reads from a small table with the given number of threads
+    // for the given time, and reports how many torn entries were read. Without
+    // the check word, entries hold the plain key, so torn ones go unnoticed.
+    static void stressTest(int threads, int ms, bool checkWord);
+};
+
+// Holds the transposition table shared by all search threads
+extern TransTable TT;
+
+#endif /* ifndef TT_HPP */
@@ -3,6 +3,7 @@
 #include "board.hpp"
 #include "search.hpp"
 #include <thread>
+#include <memory>
 #include <sstream>
 
 using namespace std;
@@ -13,12 +14,20 @@ class UCI {
 	unsigned int winc;
 	unsigned int binc;
 	unsigned int movestogo;
+    unsigned int threads;
     Board b;
     SearchInfo info;
+    // Holds a pawn table for each search thread, kept across searches so the
+    // pawn structures of one move are still there for the next
+    vector<PawnTable> pawnTables;
     thread thr;
 public:
     UCI();
     void loop();
     Move stringToMove(string s);
     void findMove(int max);
+    void bench(int depth);
+    void evalBench(int repeats);
+    void pawnBench(int repeats);
+    void keyStats(int count);
 };
\ No newline at end of file
@@ -34,132 +34,125 @@ const Bitboard sqToBB[64] = { 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048,
     9223372036854775808ULL 
 };
 
-const int index64[64] = {
-    0, 47,  1, 56, 48, 27,  2, 60,
-   57, 49, 41, 37, 28, 16,  3, 61,
-   54, 58, 35, 52, 50, 42, 21, 44,
-   38, 32, 29, 23, 17, 11,  4, 62,
-   46, 55, 26, 59, 40, 36, 15, 53,
-   34, 51, 20, 43, 31, 22, 10, 45,
-   25, 39, 14, 33, 19, 30,  9, 24,
-   13, 18,  8, 12,  7,  6,  5, 63
-};
-
-const int PieceVals[6] = {
-    100, 300, 325, 500, 900, 20000
-};
-
-const Bitboard debruijn64 = 0x03f79d71b4cb0a89ULL;
-
-Bitboard pawnAttacks[2][64];
-Bitboard knightAttacks[64];
-Bitboard kingAttacks[64];
-Bitboard betweenBB[64][64];
-Bitboard lineBB[64][64];
-Bitboard pawnFrontSpan[2][64];
+// Returns the pawn attacks of each color from every square
+static constexpr std::array<SquareTable, 2> initPawnAttacks() {
+    std::array<SquareTable, 2> attacks{};
+    for (int i = 0; i < 64; i++) {
+        Bitboard b = 1ULL << i;
+        attacks[nWhite][i] = ((b << 7) & ~HFile) | ((b << 9) & ~AFile);
+        attacks[nBlack][i] = ((b >> 7) & ~AFile) | ((b >> 9) & ~HFile);
+    }
+    return attacks;
+}
 
 
-// Initialize key bitboard constants
-void initBitboards() {
-    initmagicmoves();
+// Returns the squares in front of a pawn of each color on every square, on its
+// own and the adjacent files
+static constexpr std::array<SquareTable, 2> initPawnFrontSpan() {
+    std::array<SquareTable, 2> spans{};
     for (int i = 0; i < 64; i++) {
-        Bitboard b = sqToBB[i];
-        pawnAttacks[nWhite][i] = (b << 7) & ~HFile;
-        pawnAttacks[nWhite][i] |= (b << 9) & ~AFile;
-        pawnAttacks[nBlack][i] = (b >> 7) & ~AFile;
-        pawnAttacks[nBlack][i] |= (b >> 9) & ~HFile;
-
-        knightAttacks[i] = (b << 17) & ~AFile;
-        knightAttacks[i] |= (b << 10) & ~AFile &~BFile;
-        knightAttacks[i] |= (b >>  6) & ~AFile & ~BFile;
-        knightAttacks[i] |= (b >> 15) & ~AFile;
-        knightAttacks[i] |= (b << 15) & ~HFile;
-        knightAttacks[i] |= (b <<  6) & ~GFile & ~HFile;
-        knightAttacks[i] |= (b >> 10) & ~GFile & ~HFile;
-        knightAttacks[i] |= (b >> 17) & ~HFile;
-
-        kingAttacks[i] = (b << 1) & ~AFile;
-        kingAttacks[i] |= (b >> 1) & ~HFile;
-        kingAttacks[i] |= (kingAttacks[i] << 8) | (kingAttacks[i] >> 8);
-        kingAttacks[i] |= (b << 8) | (b >> 8);
-
         int rank = i / 8;
         int file = i & 7;
-        Bitboard frontSpan = 0x0101010101010101 << file;
-        if (file != 0) frontSpan |= 0x0101010101010101 << (file - 1);
-        if (file != 7) frontSpan |= 0x0101010101010101 << (file + 1);
-        pawnFrontSpan[nWhite][i] = frontSpan << (8 * (rank + 1));
-        pawnFrontSpan[nBlack][i] = frontSpan & ~(0xFFFFFFFFFFFFFFFF << (8 * rank));
-
-
-        // Initialize sliding bitboards
-        for (int j = 0; j <= i; j++) {
-            lineBB[i][j] = 0;
-            betweenBB[i][j] = 0;
-            if (i == j) {
-                continue;
-            }
-
-            if (slidingAttacksBB<nBishop>(i, 0) & sqToBB[j]) {
-                Bitboard diagonal = slidingAttacksBB<nBishop>(i, sqToBB[j]) &
-                    slidingAttacksBB<nBishop>(j, sqToBB[i]);
-                Bitboard lineDiagonal = (slidingAttacksBB<nBishop>(i, 0) &
-                    slidingAttacksBB<nBishop>(j, 0)) | sqToBB[i] | sqToBB[j];
-                betweenBB[i][j] = diagonal;
-                betweenBB[j][i] = diagonal;
-                lineBB[i][j] = lineDiagonal;
-                lineBB[j][i] = lineDiagonal;
-            } else if (slidingAttacksBB<nRook>(i, 0) & sqToBB[j]) {
-                betweenBB[i][j] = slidingAttacksBB<nRook>(i, sqToBB[j]) &
-                    slidingAttacksBB<nRook>(j, sqToBB[i]);
-                betweenBB[j][i] = betweenBB[i][j];
-                lineBB[i][j] = (slidingAttacksBB<nRook>(i, 0) &
-                    slidingAttacksBB<nRook>(j, 0)) | sqToBB[i] | sqToBB[j];
-                lineBB[j][i] = lineBB[i][j];
-            } else {
-                lineBB[i][j] = lineBB[j][i] = 0;
-                betweenBB[i][j] = betweenBB[j][i] = 0;
-            }
-        }
+        Bitboard frontSpan = AFile << file;
+        if (file != 0) frontSpan |= AFile << (file - 1);
+        if (file != 7) frontSpan |= AFile << (file + 1);
+        spans[nWhite][i] = (rank == 7 ? 0 : frontSpan << (8 * (rank + 1)));
+        spans[nBlack][i] = frontSpan & ~(0xFFFFFFFFFFFFFFFF << (8 * rank));
     }
+    return spans;
 }
 
 
-// Returns the least significant bit of the bitboard
-Square lsb(Bitboard b) {
-   return (Square)index64[((b ^ (b-1)) * debruijn64) >> 58];
+// Returns the knight attacks from every square
+static constexpr SquareTable initKnightAttacks() {
+    SquareTable attacks{};
+    for (int i = 0; i < 64; i++) {
+        Bitboard b = 1ULL << i;
+        attacks[i] = (b << 17) & ~AFile;
+        attacks[i] |= (b << 10) & ~AFile &~BFile;
+        attacks[i] |= (b >>  6) & ~AFile & ~BFile;
+        attacks[i] |= (b >> 15) & ~AFile;
+        attacks[i] |= (b << 15) & ~HFile;
+        attacks[i] |= (b <<  6) & ~GFile & ~HFile;
+        attacks[i] |= (b >> 10) & ~GFile & ~HFile;
+        attacks[i] |= (b >> 17) & ~HFile;
+    }
+    return attacks;
 }
 
 
-// Returns the most significant bit of the bitboard
-Square msb(Bitboard b) {
-   b |= b >> 1; 
-   b |= b >> 2;
-   b |= b >> 4;
-   b |= b >> 8;
-   b |= b >> 16;
-   b |= b >> 32;
-   return (Square)index64[(b * debruijn64) >> 58];
+// Returns the king attacks from every square
+static constexpr SquareTable initKingAttacks() {
+    SquareTable attacks{};
+    for (int i = 0; i < 64; i++) {
+        Bitboard b = 1ULL << i;
+        attacks[i] = (b << 1) & ~AFile;
+        attacks[i] |= (b >> 1) & ~HFile;
+        attacks[i] |= (attacks[i] << 8) | (attacks[i] >> 8);
+        attacks[i] |= (b << 8) | (b >> 8);
+    }
+    return attacks;
 }
 
 
-// Pops and returns the least significant bit of the bitboard
-Square pop_lsb(Bitboard* b) {
-    Square b_lsb = lsb(*b);
-    *b &= *b - 1;
-    return b_lsb;
+// Returns the squares strictly between every two squares on a shared rank,
+// file or diagonal, or the whole line through them, and nothing for squares
+// that share none
+static constexpr std::array<SquareTable, 64> initLines(bool between) {
+    std::array<SquareTable, 64> lines{};
+    for (int i = 0; i < 64; i++) {
+        for (int dir = 0; dir < 8; dir++) {
+            Bitboard ray = slowRayAttacks(i, 0, dir);
+            // the rays are ordered so that the opposite one is four apart
+            Bitboard line = ray | slowRayAttacks(i, 0, dir ^ 4) | (1ULL << i);
+            Bitboard squares = ray;
+            while (squares) {
+                int j = std::countr_zero(squares);
+                squares &= squares - 1;
+                lines[i][j] = (between ? slowRayAttacks(i, 1ULL << j, dir) &
+                        ~(1ULL << j) : line);
+            }
+        }
+    }
+    return lines;
 }
 
 
-// Returns the number of set bits
-int popcount(Bitboard b) {
-    if (b == 0) {
-        return 0;
+constexpr std::array<SquareTable, 2> pawnAttacks = initPawnAttacks();
+constexpr std::array<SquareTable, 2> pawnFrontSpan = initPawnFrontSpan();
+constexpr SquareTable knightAttacks = initKnightAttacks();
+constexpr SquareTable kingAttacks = initKingAttacks();
+constexpr std::array<SquareTable, 64> betweenBB = initLines(true);
+constexpr std::array<SquareTable, 64> lineBB = initLines(false);
+
+
+// Returns whether the CPU supports the bit instructions the engine was built
+// with
+bool bitopsSupported() {
+#if defined(__POPCNT__) || defined(__BMI__)
+    __builtin_cpu_init();
+#endif
+#ifdef __POPCNT__
+    if (!__builtin_cpu_supports("popcnt")) {
+        return false;
     }
-    int count = 0;
-    while (b) {
-        count++;
-        b &= b - 1;
+#endif
+#ifdef __BMI__
+    if (!__builtin_cpu_supports("bmi")) {
+        return false;
     }
-    return count; 
-}
\ No newline at end of file
+#endif
+    return true;
+}
+
+
+// Returns the name of the bit instructions the engine was built with
+const char* bitopsName() {
+#if defined(__POPCNT__) && defined(__BMI__)
+    return "popcnt tzcnt";
+#elif defined(__POPCNT__)
+    return "popcnt";
+#else
+    return "portable";
+#endif
+}
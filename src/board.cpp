@@ -3,54 +3,152 @@
  */
 
 #include "board.hpp"
-#include <random>
+#include "tt.hpp"
 using namespace std;
 
 // Holds zobrist random values
 namespace Zobrist {
-    unsigned long long pieces[12][64];
-    unsigned long long blackMove;
-    unsigned long long castling[4];
-    unsigned long long enPassant[8];
+    // Seed of the keys. Keys are the same on every run, so node counts can be
+    // compared between runs and saved transposition tables stay valid.
+    const unsigned long long SEED = 0x5EED0C4E55ULL;
+
+    struct Keys {
+        unsigned long long pieces[2][6][64];
+        unsigned long long blackMove;
+        unsigned long long castling[4];
+        unsigned long long enPassant[8];
+    };
+
+    // Returns the next number of a splitmix64 sequence, advancing its state
+    constexpr unsigned long long next(unsigned long long& state) {
+        unsigned long long z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Generates the 781 keys: one for each color, piece and square, one for
+    // the side to move, and one for each castling right and en passant file
+    constexpr Keys generate() {
+        Keys keys = {};
+        unsigned long long state = SEED;
+        for (int color = nWhite; color <= nBlack; color++) {
+            for (int piece = nPawn; piece <= nKing; piece++) {
+                for (int sq = A1; sq <= H8; sq++) {
+                    keys.pieces[color][piece][sq] = next(state);
+                }
+            }
+        }
+        for (int i = 0; i < 4; i++) {
+            keys.castling[i] = next(state);
+        }
+        for (int i = 0; i < 8; i++) {
+            keys.enPassant[i] = next(state);
+        }
+        keys.blackMove = next(state);
+        return keys;
+    }
+
+    // Returns whether no two keys are equal
+    constexpr bool distinct(const Keys& keys) {
+        unsigned long long flat[781] = {};
+        for (int i = 0; i < 768; i++) {
+            flat[i] = keys.pieces[i / 384][i / 64 % 6][i % 64];
+        }
+        for (int i = 0; i < 4; i++) {
+            flat[768 + i] = keys.castling[i];
+        }
+        for (int i = 0; i < 8; i++) {
+            flat[772 + i] = keys.enPassant[i];
+        }
+        flat[780] = keys.blackMove;
+        for (int i = 0; i < 781; i++) {
+            for (int j = i + 1; j < 781; j++) {
+                if (flat[i] == flat[j]) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    constexpr Keys keys = generate();
+    static_assert(distinct(keys), "Zobrist keys must be distinct");
+
+    constexpr auto& pieces = keys.pieces;
+    constexpr auto& blackMove = keys.blackMove;
+    constexpr auto& castling = keys.castling;
+    constexpr auto& enPassant = keys.enPassant;
+};
+
+
+// Holds the material and piece-square scores of each piece on each square
+namespace Material {
+    // Holds how much each piece counts towards the game phase
+    constexpr int phaseWeights[6] = {0, 1, 1, 2, 4, 0};
+
+    // Returns the score of every color, piece and square, with the piece
+    // square tables mirrored for black
+    constexpr auto generate() {
+        std::array<std::array<std::array<PhaseScore, 64>, 6>, 2> scores{};
+        for (int color = nWhite; color <= nBlack; color++) {
+            for (int piece = nPawn; piece <= nKing; piece++) {
+                for (int sq = A1; sq <= H8; sq++) {
+                    int index = (color == nWhite ? sq : 8 * (7 - sq / 8) + (sq & 7));
+                    int mid = PieceVals[piece] + pieceTable[piece][index];
+                    int end = PieceVals[piece] + (piece == nKing ?
+                            kingTableEndgame[index] : pieceTable[piece][index]);
+                    scores[color][piece][sq] = {mid, end};
+                }
+            }
+        }
+        return scores;
+    }
+
+    constexpr auto psq = generate();
 };
 
 
-// Initializes 81 random 64-bit numbers.
-void initZobrist() {
-    random_device rd;
-    mt19937_64 eng(rd());
-    uniform_int_distribution<unsigned long long> distr;
+// Returns a hash of all the Zobrist keys, which identifies the key set
+unsigned long long zobristSignature() {
+    unsigned long long signature = 0;
     for (int color = nWhite; color <= nBlack; color++) {
         for (int piece = nPawn; piece <= nKing; piece++) {
             for (int sq = A1; sq <= H8; sq++) {
-                Zobrist::pieces[2 * color + piece][sq] = distr(eng);
+                signature = (signature ^ Zobrist::pieces[color][piece][sq]) *
+                    0x100000001B3ULL;
             }
         }
     }
     for (int i = 0; i < 4; i++) {
-        Zobrist::castling[i] = distr(eng);
+        signature = (signature ^ Zobrist::castling[i]) * 0x100000001B3ULL;
     }
     for (int i = 0; i < 8; i++) {
-        Zobrist::enPassant[i] = distr(eng);
+        signature = (signature ^ Zobrist::enPassant[i]) * 0x100000001B3ULL;
     }
-    Zobrist::blackMove = distr(eng);
+    return (signature ^ Zobrist::blackMove) * 0x100000001B3ULL;
 }
 
 
 // Initializes the zobrist hash key to the current board position
 void Board::setZobrist() {
     unsigned long long hashKey = 0;
+    unsigned long long pawnKey = 0;
     for (int color = nWhite; color <= nBlack; color++) {
         for (int piece = nPawn; piece <= nKing; piece++) {
             Bitboard pieces = getPieces((Color)color, (Piece)piece);
             while (pieces) {
                 int sq = pop_lsb(&pieces);
-                hashKey ^= Zobrist::pieces[2 * color + piece][sq];
+                hashKey ^= Zobrist::pieces[color][piece][sq];
+                if (piece == nPawn) {
+                    pawnKey ^= Zobrist::pieces[color][piece][sq];
+                }
             }
         }
     }
 
-    short castle = castling.top();
+    StateInfo& st = history[histPly];
+    short castle = st.castling;
     for (int i = 0; i < 4; i++) {
         if (castle & (1 << i)) {
             hashKey ^= Zobrist::castling[i];
@@ -61,17 +159,44 @@ void Board::setZobrist() {
         hashKey ^= Zobrist::blackMove;
     }
 
-    if (enPassant.top() != SQ_NONE) {
-        hashKey ^= Zobrist::enPassant[enPassant.top() % 8];
+    if (st.enPassant != SQ_NONE) {
+        hashKey ^= Zobrist::enPassant[st.enPassant % 8];
+    }
+    st.zobrist = hashKey;
+    st.pawnZobrist = pawnKey;
+}
+
+
+// Sets the board's material and phase weight to the ones counted from scratch
+void Board::setMaterial() {
+    StateInfo& st = history[histPly];
+    st.material[nWhite] = countMaterial(nWhite);
+    st.material[nBlack] = countMaterial(nBlack);
+    st.phaseWeight = 0;
+    for (int piece = nKnight; piece <= nQueen; piece++) {
+        st.phaseWeight += Material::phaseWeights[piece] * popcount(getPieces(
+                    (Piece)piece));
+    }
+}
+
+
+// Returns whether the material and phase weight kept by makeMove and unmakeMove
+// match the ones counted from scratch
+bool Board::materialMatches() const {
+    const StateInfo& st = history[histPly];
+    int phaseWeight = 0;
+    for (int piece = nKnight; piece <= nQueen; piece++) {
+        phaseWeight += Material::phaseWeights[piece] * popcount(getPieces(
+                    (Piece)piece));
     }
-    zobrist.push_back(hashKey);
+    return st.material[nWhite] == countMaterial(nWhite) &&
+        st.material[nBlack] == countMaterial(nBlack) &&
+        st.phaseWeight == phaseWeight;
 }
 
 
 // Constructs a new Board object
 Board::Board() {
-    initZobrist();
-
     // initialize pieces
     pieceBB[0] = Rank1 | Rank2;
     pieceBB[1] = Rank7 | Rank8;
@@ -85,14 +210,24 @@ Board::Board() {
     occupiedBB = (pieceBB[0] | pieceBB[1]);
     emptyBB = ~occupiedBB;
 
-    enPassant.push(SQ_NONE);
-    castling.push(0b1111);
-    capturedList.push(PIECE_NONE);
+    std::fill(board, board + 64, PIECE_NONE);
+    for (int piece = nPawn; piece <= nKing; piece++) {
+        Bitboard pieces = pieceBB[2 + piece];
+        while (pieces) {
+            board[pop_lsb(&pieces)] = (Piece)piece;
+        }
+    }
+
+    histPly = 0;
+    history[0].enPassant = SQ_NONE;
+    history[0].castling = 0b1111;
+    history[0].captured = PIECE_NONE;
+    history[0].fiftyCount = 0;
     toMove = nWhite;
-    fiftyList.push(0);
     fullMove = 1;
 
     setZobrist();
+    setMaterial();
 }
 
 
@@ -102,7 +237,6 @@ Board::Board() {
  * @param FEN the desired starting position in FEN form
  */
 Board::Board(std::string FEN) {
-    initZobrist();
     setPosition(FEN);
 }
 
@@ -113,17 +247,9 @@ Board::Board(std::string FEN) {
  * @param FEN the desired position the board will be sent to.
  */
 void Board::setPosition(std::string FEN) {
-    enPassant = stack<Square>();
-    castling = stack<short>();
-    fiftyList = stack<int>();
-    capturedList = stack<Piece>();
-    zobrist = vector<unsigned long long>();
-    //for (int i = 0; i < 100000; i++)
-    //    transTable[i] = HashEntry();
-    // initializes killer move list
-    //for (int i = 0; i < SEARCH_DEPTH + 1; i++)
-    //    for (int j = 0; j < 2; j++)
-    //        killerMoves[i][j] = Move();
+    histPly = 0;
+    StateInfo& st = history[0];
+    st.captured = PIECE_NONE;
 
     pieceBB[0] = 0; 
     pieceBB[1] = 0;
@@ -133,6 +259,7 @@ void Board::setPosition(std::string FEN) {
     pieceBB[5] = 0;
     pieceBB[6] = 0;
     pieceBB[7] = 0;
+    std::fill(board, board + 64, PIECE_NONE);
 
     std::vector<std::string> result;
     std::vector<std::string> pieceList;
@@ -185,6 +312,7 @@ void Board::setPosition(std::string FEN) {
             }
             pieceBB[c] |= sqToBB[(7 - i) * 8 + currSq];
             pieceBB[2 + p] |= sqToBB[(7 - i) * 8 + currSq];
+            board[(7 - i) * 8 + currSq] = p;
             currSq++;
         }
     }
@@ -209,21 +337,21 @@ void Board::setPosition(std::string FEN) {
                 break;
         }
     }
-    castling.push(castle);
+    st.castling = castle;
 
     // en passant
     if (result[3] == "-") {
-        enPassant.push(SQ_NONE);
+        st.enPassant = SQ_NONE;
     } else {
-        enPassant.push((Square)(std::find(squareNames, squareNames+65, result[3]) -
-                    squareNames));
+        st.enPassant = (Square)(std::find(squareNames, squareNames+65, result[3]) -
+                    squareNames);
     }
 
     if (result.size() == 6) {
-        fiftyList.push(stoi(result[4]));
+        st.fiftyCount = stoi(result[4]);
         fullMove = stoi(result[5]);
     } else {
-        fiftyList.push(0);
+        st.fiftyCount = 0;
         fullMove = 1;
     }
 
@@ -231,6 +359,7 @@ void Board::setPosition(std::string FEN) {
     emptyBB = ~occupiedBB;
 
     setZobrist(); 
+    setMaterial();
 }
 
 
@@ -288,7 +417,7 @@ std::string Board::getFEN() const {
     FEN += (toMove == nWhite ? "w" : "b");
     FEN += " ";
 
-    short castle = castling.top();
+    short castle = history[histPly].castling;
     if (castle & 0b1000) {
         FEN += "K";
     }  
@@ -307,10 +436,11 @@ std::string Board::getFEN() const {
         FEN += "- ";
     }
 
-    FEN += (enPassant.top() == SQ_NONE ? "-" : squareNames[enPassant.top()]);
+    Square ep = history[histPly].enPassant;
+    FEN += (ep == SQ_NONE ? "-" : squareNames[ep]);
     FEN += " ";
 
-    FEN += std::to_string(fiftyList.top()) + " " + std::to_string(fullMove);
+    FEN += std::to_string(history[histPly].fiftyCount) + " " + std::to_string(fullMove);
 
     return FEN;
 }
@@ -336,35 +466,16 @@ Bitboard Board::getPieces(Color ct, Piece pt) const {
 
 // Returns the piece on a given square
 Piece Board::getPiece(int sq) const {
-    Bitboard sqBB = sqToBB[sq];
-    if (sqBB & pieceBB[2 + nPawn]) {
-        return nPawn;
-    } else if (sqBB & pieceBB[2 + nKnight]) {
-        return nKnight;
-    } else if (sqBB & pieceBB[2 + nBishop]) {
-        return nBishop;
-    } else if (sqBB & pieceBB[2 + nRook]) {
-        return nRook;
-    } else if (sqBB & pieceBB[2 + nQueen]) {
-        return nQueen;
-    } else if (sqBB & pieceBB[2 + nKing]) {
-        return nKing;
-    } else {
-        return PIECE_NONE;
-    }
+    return board[sq];
 }
 
 
 // Returns the color of the piece on the given square
 Color Board::getColor(int sq) const {
-    Bitboard sqBB = sqToBB[sq];
-    if (sqBB & pieceBB[nWhite]) {
-        return nWhite;
-    } else if (sqBB & pieceBB[nBlack]) {
-        return nBlack;
-    } else {
+    if (board[sq] == PIECE_NONE) {
         return COLOR_NONE;
     }
+    return (Color)((pieceBB[nBlack] >> sq) & 1);
 }
 
 
@@ -405,13 +516,13 @@ Bitboard Board::getEmpty() const {
 
 // Returns the square that is the en passant target, if it exists
 Square Board::enPassantTarget() const {
-    return enPassant.top();
+    return history[histPly].enPassant;
 }
 
 
 // Returns the castling rights of the board
 short Board::getCastlingRights() const {
-    return castling.top();
+    return history[histPly].castling;
 }
 
 
@@ -423,18 +534,36 @@ Color Board::getToMove() const {
 
 // Returns the zobrist hash key
 unsigned long long Board::getZobrist() const {
-    return zobrist.back();
+    return history[histPly].zobrist;
+}
+
+
+// Returns the zobrist hash key of the pawns
+unsigned long long Board::getPawnZobrist() const {
+    return history[histPly].pawnZobrist;
 }
 
 
 // Returns the fifty move counter
 int Board::getFiftyCount() const {
-    return fiftyList.top();
+    return history[histPly].fiftyCount;
+}
+
+
+int Board::getHistoryRoom() const {
+    return MAX_HISTORY - 1 - histPly;
 }
 
 
 // Returns whether a square is attacked by a given side
 bool Board::attacked(int square, Color side) const {
+    return attacked(square, side, occupiedBB);
+}
+
+
+// Returns whether a square is attacked by a given side when the board has the
+// given occupancy
+bool Board::attacked(int square, Color side, Bitboard occupied) const {
     Bitboard pawns = getPieces(side, nPawn);
     if (pawnAttacks[side^1][square] & pawns) {
         return true;
@@ -448,40 +577,17 @@ bool Board::attacked(int square, Color side) const {
         return true;
     }
     Bitboard bishopsQueens = getPieces(side, nQueen) | getPieces(side, nBishop);
-    if (slidingAttacksBB<nBishop>(square, occupiedBB) & bishopsQueens) {
+    if (slidingAttacksBB<nBishop>(square, occupied) & bishopsQueens) {
         return true;
     }
     Bitboard rooksQueens = getPieces(side, nQueen) | getPieces(side, nRook);
-    if (slidingAttacksBB<nRook>(square, occupiedBB) & rooksQueens) {
+    if (slidingAttacksBB<nRook>(square, occupied) & rooksQueens) {
         return true;
     }
     return false;
 }
 
 
-// Returns a bitboard holding the pieces attacking the square of the given
-// color
-Bitboard Board::getAttackers(Square sq, Color c) const {
-    Color other = (toMove == nWhite ? nBlack : nWhite);
-    Bitboard attackers = 0;
-
-    attackers |= (pawnAttacks[toMove][sq] & getPieces(other, nPawn));
-    attackers |= (knightAttacks[sq] & getPieces(other, nKnight));
-
-    Bitboard bishopsQueens = getPieces(other, nQueen) | getPieces(other,
-            nBishop);
-    attackers |= (slidingAttacksBB<nBishop>(sq, occupiedBB) & bishopsQueens);
-
-    Bitboard rooksQueens = getPieces(other, nQueen) | getPieces(other, nRook);
-    attackers |= (slidingAttacksBB<nRook>(sq, occupiedBB) & rooksQueens);
-
-    Bitboard kings = getPieces(other, nKing);
-    attackers |= (kingAttacks[sq] & kings);
-
-    return attackers;
-}
-
-
 // Returns a color's least valuable attacker of a square
 Square Board::lva(Square sq, Color side) const {
     Bitboard pawns = getPieces(side, nPawn);
@@ -602,9 +708,16 @@ Bitboard Board::pinnedPieces(Bitboard pinners, Square sq) const {
 
 // Makes a legal move on the chessboard
 void Board::makeMove(Move m) {
-    unsigned long long hashKey = zobrist.back();
+    const StateInfo& prev = history[histPly];
+    StateInfo& st = history[++histPly];
+    assert(histPly < MAX_HISTORY);
+
+    unsigned long long hashKey = prev.zobrist;
+    unsigned long long pawnKey = prev.pawnZobrist;
+    PhaseScore material[2] = {prev.material[nWhite], prev.material[nBlack]};
+    int phaseWeight = prev.phaseWeight;
     // increments move counters
-    int fiftyCounter = fiftyList.top() + 1;
+    int fiftyCounter = prev.fiftyCount + 1;
     if (toMove == nBlack) { 
         fullMove++;
     }
@@ -631,27 +744,35 @@ void Board::makeMove(Move m) {
 
     pieceBB[(int)startP + 2] ^= startEndBB; 
     pieceBB[(int)startC] ^= startEndBB;
+    board[start] = PIECE_NONE;
+    board[end] = startP;
+
+    hashKey ^= Zobrist::pieces[startC][startP][start];
+    hashKey ^= Zobrist::pieces[startC][startP][end];
+    material[startC] += Material::psq[startC][startP][end] -
+        Material::psq[startC][startP][start];
+    if (startP == nPawn) {
+        pawnKey ^= Zobrist::pieces[startC][nPawn][start];
+        pawnKey ^= Zobrist::pieces[startC][nPawn][end];
+    }
 
-    hashKey ^= Zobrist::pieces[2 * startC + startP][start];
-    hashKey ^= Zobrist::pieces[2 * startC + startP][end];
-
-    short newCastling = castling.top();
+    short newCastling = prev.castling;
 
     // Resets fifty move counter if pawn move or capture
     if (startP == nPawn || capture) {
         fiftyCounter = 0;
     }
 
-    if (enPassant.top() != SQ_NONE) {
-        hashKey ^= Zobrist::enPassant[enPassant.top() % 8];
+    if (prev.enPassant != SQ_NONE) {
+        hashKey ^= Zobrist::enPassant[prev.enPassant % 8];
     }
 
     // Double pawn move
     if (flags == 1) {
-        enPassant.push((Square)(startC == nWhite ? end - 8 : end + 8));
-        hashKey ^= Zobrist::enPassant[enPassant.top() % 8];
+        st.enPassant = (Square)(startC == nWhite ? end - 8 : end + 8);
+        hashKey ^= Zobrist::enPassant[st.enPassant % 8];
     } else {
-        enPassant.push(SQ_NONE);
+        st.enPassant = SQ_NONE;
     }
 
     if (flags == 5) { // en passant
@@ -659,52 +780,84 @@ void Board::makeMove(Move m) {
         if (startC == nWhite) {
             pieceBB[2] ^= sqToBB[end - 8];    
             pieceBB[1] ^= sqToBB[end - 8];
-            hashKey ^= Zobrist::pieces[2 * nBlack + nPawn][end - 8];
+            board[end - 8] = PIECE_NONE;
+            hashKey ^= Zobrist::pieces[nBlack][nPawn][end - 8];
+            pawnKey ^= Zobrist::pieces[nBlack][nPawn][end - 8];
+            material[nBlack] -= Material::psq[nBlack][nPawn][end - 8];
         } else {
             pieceBB[2] ^= sqToBB[end + 8];    
             pieceBB[0] ^= sqToBB[end + 8];
-            hashKey ^= Zobrist::pieces[2 * nWhite + nPawn][end + 8];
+            board[end + 8] = PIECE_NONE;
+            hashKey ^= Zobrist::pieces[nWhite][nPawn][end + 8];
+            pawnKey ^= Zobrist::pieces[nWhite][nPawn][end + 8];
+            material[nWhite] -= Material::psq[nWhite][nPawn][end + 8];
         }
     } else if (capture) {
         pieceBB[(int) endP + 2] ^= endBB;
         pieceBB[(int) endC] ^= endBB;
-        hashKey ^= Zobrist::pieces[2 * endC + endP][end];
+        hashKey ^= Zobrist::pieces[endC][endP][end];
+        material[endC] -= Material::psq[endC][endP][end];
+        phaseWeight -= Material::phaseWeights[endP];
+        if (endP == nPawn) {
+            pawnKey ^= Zobrist::pieces[endC][nPawn][end];
+        }
     }
 
     if (prom) {
         int promPiece = 1 + (flags & 3);
         pieceBB[promPiece + 2] ^= endBB;
         pieceBB[2] ^= endBB;
-        hashKey ^= Zobrist::pieces[2 * startC + promPiece][end];
-        hashKey ^= Zobrist::pieces[2 * startC + nPawn][end];
+        board[end] = (Piece)promPiece;
+        hashKey ^= Zobrist::pieces[startC][promPiece][end];
+        hashKey ^= Zobrist::pieces[startC][nPawn][end];
+        pawnKey ^= Zobrist::pieces[startC][nPawn][end];
+        material[startC] += Material::psq[startC][promPiece][end] -
+            Material::psq[startC][nPawn][end];
+        phaseWeight += Material::phaseWeights[promPiece];
     } 
 
     if (flags == 2) { // castling
         if (startC == nWhite) {
             pieceBB[nRook + 2] ^= (sqToBB[F1] | sqToBB[H1]);
             pieceBB[startC] ^= (sqToBB[F1] | sqToBB[H1]);
-            hashKey ^= Zobrist::pieces[2 * nWhite + nRook][F1];
-            hashKey ^= Zobrist::pieces[2 * nWhite + nRook][H1];
+            board[H1] = PIECE_NONE;
+            board[F1] = nRook;
+            hashKey ^= Zobrist::pieces[nWhite][nRook][F1];
+            hashKey ^= Zobrist::pieces[nWhite][nRook][H1];
+            material[nWhite] += Material::psq[nWhite][nRook][F1] -
+                Material::psq[nWhite][nRook][H1];
             newCastling &= 0b0011;
         } else { 
             pieceBB[nRook + 2] ^= (sqToBB[F8] | sqToBB[H8]);
             pieceBB[startC] ^= (sqToBB[F8] | sqToBB[H8]);
-            hashKey ^= Zobrist::pieces[2 * nBlack + nRook][F8];
-            hashKey ^= Zobrist::pieces[2 * nBlack + nRook][H8];
+            board[H8] = PIECE_NONE;
+            board[F8] = nRook;
+            hashKey ^= Zobrist::pieces[nBlack][nRook][F8];
+            hashKey ^= Zobrist::pieces[nBlack][nRook][H8];
+            material[nBlack] += Material::psq[nBlack][nRook][F8] -
+                Material::psq[nBlack][nRook][H8];
             newCastling &= 0b1100;
         }
     } else if (flags == 3)  { // queenside
         if (startC == nWhite) {
             pieceBB[nRook + 2] ^= (sqToBB[A1] | sqToBB[D1]);
             pieceBB[startC] ^= (sqToBB[A1] | sqToBB[D1]);
-            hashKey ^= Zobrist::pieces[2 * nWhite + nRook][A1];
-            hashKey ^= Zobrist::pieces[2 * nWhite + nRook][D1];
+            board[A1] = PIECE_NONE;
+            board[D1] = nRook;
+            hashKey ^= Zobrist::pieces[nWhite][nRook][A1];
+            hashKey ^= Zobrist::pieces[nWhite][nRook][D1];
+            material[nWhite] += Material::psq[nWhite][nRook][D1] -
+                Material::psq[nWhite][nRook][A1];
             newCastling &= 0b0011;
         } else { 
             pieceBB[nRook + 2] ^= (sqToBB[A8] | sqToBB[D8]);
             pieceBB[startC] ^= (sqToBB[A8] | sqToBB[D8]);
-            hashKey ^= Zobrist::pieces[2 * nBlack + nRook][A8];
-            hashKey ^= Zobrist::pieces[2 * nBlack + nRook][D8];
+            board[A8] = PIECE_NONE;
+            board[D8] = nRook;
+            hashKey ^= Zobrist::pieces[nBlack][nRook][A8];
+            hashKey ^= Zobrist::pieces[nBlack][nRook][D8];
+            material[nBlack] += Material::psq[nBlack][nRook][D8] -
+                Material::psq[nBlack][nRook][A8];
             newCastling &= 0b1100;
         }
     } 
@@ -741,19 +894,32 @@ void Board::makeMove(Move m) {
         }
     }
 
+    // swap out the keys of the rights that were lost
+    short lostCastling = prev.castling ^ newCastling;
     for (int i = 0; i < 4; i++) {
-        if (newCastling & (1 << i)) {
+        if (lostCastling & (1 << i)) {
             hashKey ^= Zobrist::castling[i];
         }
     }
 
-    castling.push(newCastling);
+    st.castling = newCastling;
+
+    // the child's key is known, so start fetching its table entry while the
+    // rest of the move is made
+    TT.prefetch(hashKey);
 
     occupiedBB = (pieceBB[0] | pieceBB[1]);
     emptyBB = ~occupiedBB;
-    capturedList.push(endP);
-    fiftyList.push(fiftyCounter);
-    zobrist.push_back(hashKey);
+    st.captured = endP;
+    st.fiftyCount = fiftyCounter;
+    st.zobrist = hashKey;
+    st.pawnZobrist = pawnKey;
+    st.material[nWhite] = material[nWhite];
+    st.material[nBlack] = material[nBlack];
+    st.phaseWeight = phaseWeight;
+#ifdef CHECK_EVAL
+    assert(materialMatches());
+#endif
 }
 
 
@@ -766,17 +932,13 @@ void Board::unmakeMove(Move m) {
 
     toMove = (toMove == nWhite ? nBlack : nWhite);
         
-    Piece endP = capturedList.top();
+    Piece endP = history[histPly].captured;
 
     bool prom = m.isPromotion();
     bool capture = m.isCapture();
 
-    // makes lists previous state
-    castling.pop();
-    enPassant.pop();
-    capturedList.pop();
-    fiftyList.pop();
-    zobrist.pop_back();
+    // returns to the previous state
+    histPly--;
     int start = m.getFrom();
     int end = m.getTo();
     int flags = m.getFlags();
@@ -791,19 +953,24 @@ void Board::unmakeMove(Move m) {
 
     pieceBB[(int)startP + 2] ^= startEndBB; 
     pieceBB[(int)startC] ^= startEndBB;
+    board[start] = startP;
+    board[end] = PIECE_NONE;
 
     if (flags == 5) { // en passant
         endP = nPawn;
         if (startC == nWhite) {
             pieceBB[2] ^= sqToBB[end - 8];    
             pieceBB[1] ^= sqToBB[end - 8];
+            board[end - 8] = nPawn;
         } else {
             pieceBB[2] ^= sqToBB[end + 8];    
             pieceBB[0] ^= sqToBB[end + 8];
+            board[end + 8] = nPawn;
         }
     } else if (capture) {
         pieceBB[(int) endP + 2] ^= endBB;
         pieceBB[(int) other] ^= endBB;
+        board[end] = endP;
     }
 
     if (prom) {
@@ -816,36 +983,53 @@ void Board::unmakeMove(Move m) {
         if (startC == nWhite) {
             pieceBB[nRook + 2] ^= (sqToBB[F1] | sqToBB[H1]);
             pieceBB[startC] ^= (sqToBB[F1] | sqToBB[H1]);
+            board[H1] = nRook;
+            board[F1] = PIECE_NONE;
         } else { 
             pieceBB[nRook + 2] ^= (sqToBB[F8] | sqToBB[H8]);
             pieceBB[startC] ^= (sqToBB[F8] | sqToBB[H8]);
+            board[H8] = nRook;
+            board[F8] = PIECE_NONE;
         }
     } else if (flags == 3) { // queenside
         if (startC == nWhite) {
             pieceBB[nRook + 2] ^= (sqToBB[A1] | sqToBB[D1]);
             pieceBB[startC] ^= (sqToBB[A1] | sqToBB[D1]);
+            board[A1] = nRook;
+            board[D1] = PIECE_NONE;
         } else { 
             pieceBB[nRook + 2] ^= (sqToBB[A8] | sqToBB[D8]);
             pieceBB[startC] ^= (sqToBB[A8] | sqToBB[D8]);
+            board[A8] = nRook;
+            board[D8] = PIECE_NONE;
         }
     } 
 
     occupiedBB = (pieceBB[0] | pieceBB[1]);
     emptyBB = ~occupiedBB;
+#ifdef CHECK_EVAL
+    assert(materialMatches());
+#endif
 }
 
 
 // Makes a null move (switches color) for the current position
 void Board::makeNullMove() {
-    unsigned long long hashKey = zobrist.back();
+    const StateInfo& prev = history[histPly];
+    StateInfo& st = history[++histPly];
+    assert(histPly < MAX_HISTORY);
+
+    unsigned long long hashKey = prev.zobrist;
     hashKey ^= Zobrist::blackMove;
     
-    if (enPassant.top() != SQ_NONE) {
-        hashKey ^= Zobrist::enPassant[enPassant.top() % 8];
+    if (prev.enPassant != SQ_NONE) {
+        hashKey ^= Zobrist::enPassant[prev.enPassant % 8];
     }
-    enPassant.push(SQ_NONE);
-    capturedList.push(PIECE_NONE);
-    zobrist.push_back(hashKey);
+    st = prev;
+    st.enPassant = SQ_NONE;
+    st.captured = PIECE_NONE;
+    TT.prefetch(hashKey);
+    st.zobrist = hashKey;
 
     toMove = (toMove == nWhite ? nBlack : nWhite);
 }
@@ -853,14 +1037,118 @@ void Board::makeNullMove() {
 
 // Unmakes a null move for the current position
 void Board::unmakeNullMove() {
-    enPassant.pop();
-    capturedList.pop();
-    zobrist.pop_back();
+    histPly--;
 
     toMove = (toMove == nWhite ? nBlack : nWhite);
 }
 
 
+// Checks if a move that may come from another position, such as a table move or
+// a killer, is pseudo-legal here. Castling moves are checked in full, and other
+// moves must also answer any check, which leaves only pins and the king's safety
+// to isLegal.
+bool Board::isPseudoLegal(Move m) const {
+    int start = m.getFrom();
+    int end = m.getTo();
+    int flags = m.getFlags();
+    Piece piece = board[start];
+    Color other = (toMove == nWhite ? nBlack : nWhite);
+    bool capture = m.isCapture();
+
+    if (piece == PIECE_NONE || !(sqToBB[start] & pieceBB[toMove])) {
+        return false;
+    }
+    if ((sqToBB[end] & pieceBB[toMove]) || flags == 6 || flags == 7) {
+        return false;
+    }
+
+    // the capture flag has to match the destination square
+    if (flags == 5) {
+        if (piece != nPawn || end != history[histPly].enPassant) {
+            return false;
+        }
+    } else if (capture != (board[end] != PIECE_NONE) || board[end] == nKing) {
+        return false;
+    }
+
+    if (flags == 2 || flags == 3) {
+        bool kingSide = (flags == 2);
+        Square kingStart = (toMove == nWhite ? E1 : E8);
+        Square kingEnd = kingSide ? (toMove == nWhite ? G1 : G8) : (toMove ==
+                nWhite ? C1 : C8);
+        Square rookSq = kingSide ? (toMove == nWhite ? H1 : H8) : (toMove ==
+                nWhite ? A1 : A8);
+        if (piece != nKing || start != kingStart || end != kingEnd) {
+            return false;
+        }
+        if (!((history[histPly].castling >> (2 * other + kingSide)) & 1)) {
+            return false;
+        }
+        if (betweenBB[kingStart][rookSq] & occupiedBB) {
+            return false;
+        }
+        int step = (kingSide ? WEST : EAST);
+        for (int i = kingEnd; i != kingStart; i += step) {
+            if (attacked(i, other)) {
+                return false;
+            }
+        }
+        return !inCheck();
+    }
+
+    Bitboard targets;
+    int up = (toMove == nWhite ? 8 : -8);
+    if (piece == nPawn) {
+        if (capture) {
+            targets = pawnAttacks[toMove][start];
+        } else if (flags == 1) {
+            Bitboard secondRank = (toMove == nWhite ? Rank2 : Rank7);
+            bool clear = !(sqToBB[start + up] & occupiedBB);
+            targets = ((sqToBB[start] & secondRank) && clear && end - start == 2 *
+                    up) ? sqToBB[end] : 0;
+        } else {
+            targets = (end - start == up ? sqToBB[end] : 0);
+        }
+        if (((sqToBB[end] & (Rank1 | Rank8)) != 0) != m.isPromotion()) {
+            return false;
+        }
+    } else {
+        if (m.isPromotion() || flags == 1) {
+            return false;
+        }
+        if (piece == nKnight) {
+            targets = knightAttacks[start];
+        } else if (piece == nBishop) {
+            targets = slidingAttacksBB<nBishop>(start, occupiedBB);
+        } else if (piece == nRook) {
+            targets = slidingAttacksBB<nRook>(start, occupiedBB);
+        } else if (piece == nQueen) {
+            targets = slidingAttacksBB<nQueen>(start, occupiedBB);
+        } else {
+            targets = kingAttacks[start];
+        }
+    }
+    if (!(targets & sqToBB[end])) {
+        return false;
+    }
+
+    // other pieces than the king have to capture or block a single checker
+    Bitboard checkers = getCheckers();
+    if (checkers && piece != nKing) {
+        if (checkers & (checkers - 1)) {
+            return false;
+        }
+        int kingSquare = lsb(getPieces(toMove, nKing));
+        Bitboard evasions = betweenBB[lsb(checkers)][kingSquare] | checkers;
+        Bitboard changed = sqToBB[end] | (flags == 5 ? sqToBB[end - up] : 0);
+        if (!(evasions & changed)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
 // Checks if a pseudo-legal move is legal
 bool Board::isLegal(Move m) const {
     int start = m.getFrom();
@@ -896,7 +1184,7 @@ bool Board::isLegal(Move m) const {
         return false;
     }
     if (m.getFlags() == 5) { // en passant
-        if (end != enPassant.top()) {
+        if (end != history[histPly].enPassant) {
             return false;
         }
         if (endColor != COLOR_NONE || startPiece != nPawn) {
@@ -918,9 +1206,10 @@ bool Board::isLegal(Move m) const {
     }
 
 
+    // the king can't stay on the line of a slider it moves away from
     if (startPiece == nKing) {
         return m.getFlags() == 2 || m.getFlags() == 3 || !attacked((Square)m.getTo(),
-                other);
+                other, occupiedBB ^ sqToBB[start]);
     }
 
     int kingSquare = lsb(getPieces(toMove, nKing));
@@ -933,31 +1222,21 @@ bool Board::isLegal(Move m) const {
 }
 
 
-// Gets an entry from the transposition table
-HashEntry Board::getTransTable(int key) const {
-    return transTable[key];
-}
-
-
-// Updates an entry in the transposition table
-void Board::setTransTable(int key, HashEntry entry) {
-   transTable[key] = entry;
-}
-
-
 // Returns whether this position has been repeated at some point
 bool Board::isRep() {
-    unsigned long long z = zobrist.back();
-    zobrist.pop_back();
-    bool rep = find(zobrist.begin(), zobrist.end(), z) != zobrist.end();
-    zobrist.push_back(z);
-    return rep;
+    unsigned long long z = history[histPly].zobrist;
+    for (int i = histPly - 1; i >= 0; i--) {
+        if (history[i].zobrist == z) {
+            return true;
+        }
+    }
+    return false;
 }
 
 
 // Prints out the principal variation up to a given depth
 void Board::printPV(int depth) {
-    HashEntry tt = getTransTable(getZobrist() % 100000);
+    HashEntry tt = TT.probe(getZobrist());
     Move m = tt.move;
     if (tt.nodeType != HASH_NULL && !(m == Move()) && depth != 0) {
         if (isLegal(m)) {
@@ -1038,56 +1317,64 @@ void Board::printBoard() const {
 
 
 // Returns the evaluation of the board's score
-int Board::boardScore() const {
-    int endgameScore = materialCount(nWhite, true) - materialCount(nBlack,
-            true);
-    int openScore = materialCount(nWhite, false) - materialCount(nBlack,
-            false);
-    int phase = boardPhase();
-    int score = ((openScore * (256 - phase)) + (endgameScore * phase)) / 256;
-    score -= 12 * (getIsolatedPawns(nWhite) - getIsolatedPawns(nBlack));
-    score -= 15 * (getBackwardPawns(nWhite) - getBackwardPawns(nBlack));
-    score -= 18 * (getDoubledPawns(nWhite) - getDoubledPawns(nBlack));
-    score += (mobilityScore(nWhite) - mobilityScore(nBlack));
-    score += (passedScore(nWhite) - passedScore(nBlack));
-    score += (safetyScore(nWhite) - safetyScore(nBlack));
+int Board::boardScore(PawnTable& pawnTable) const {
+    int score = whiteMaterialScore();
+    const PawnEntry& pawns = pawnEntry(pawnTable);
+    score += pawns.score;
+    AttackInfo info;
+    getAttackInfo(info);
+    score += (info.mobility[nWhite] - info.mobility[nBlack]);
+    score += (passedScore(nWhite, pawns.passers[nWhite]) - passedScore(nBlack,
+                pawns.passers[nBlack]));
+    score += (safetyScore(info, nWhite) - safetyScore(info, nBlack));
+
+    return (toMove == nWhite ? score : -score);
+}
+
 
+// Returns the material and piece-square part of the evaluation, which makeMove
+// keeps up to date and so costs next to nothing
+int Board::materialScore() const {
+    int score = whiteMaterialScore();
     return (toMove == nWhite ? score : -score);
 }
 
 
+// Returns the material and piece-square score from white's view, blended by
+// the game phase
+int Board::whiteMaterialScore() const {
+    const StateInfo& st = history[histPly];
+    PhaseScore material = st.material[nWhite] - st.material[nBlack];
+    int phase = boardPhase();
+    return ((material.mid * (256 - phase)) + (material.end * phase)) / 256;
+}
+
+
+// Returns the game phase from 0 in the opening to 256 in the endgame
 int Board::boardPhase() const {
     int totalPhase = 32;
-    int phase = totalPhase;
-
-    phase -= popcount(getPieces(nKnight));
-    phase -= popcount(getPieces(nBishop));
-    phase -= popcount(getPieces(nRook)) * 2;
-    phase -= popcount(getPieces(nQueen)) * 4;
+    int phase = totalPhase - history[histPly].phaseWeight;
 
     return (phase * 256 + (totalPhase / 2)) / totalPhase;
 }
-// Returns the amount of material for the given color
+
+
+// Returns the amount of material for the given color, which makeMove and
+// unmakeMove keep up to date
 int Board::materialCount(Color c, bool endgame) const {
-    int score = 0;
+    const PhaseScore& material = history[histPly].material[c];
+    return (endgame ? material.end : material.mid);
+}
+
+
+// Returns the material and piece-square score of the given color, counted from
+// scratch
+PhaseScore Board::countMaterial(Color c) const {
+    PhaseScore score = {0, 0};
     for (int p = nPawn; p <= nKing; p++) {
         Bitboard pieces = getPieces(c, (Piece)p);
         while (pieces) {
-            Square sq = pop_lsb(&pieces);
-            score += PieceVals[p];
-            if (c == nWhite) {
-                if (p == nKing && endgame) {
-                    score += kingTableEndgame[sq];
-                } else {
-                    score += pieceTable[p][sq];
-                }
-            } else {
-                if (p == nKing && endgame) {
-                    score += kingTableEndgame[8 * (7 - sq / 8) + (sq & 7)];
-                } else {
-                    score += pieceTable[p][8 * (7 - sq / 8) + (sq & 7)];
-                }
-            }
+            score += Material::psq[c][p][pop_lsb(&pieces)];
         }
     }
     return score;
@@ -1096,200 +1383,197 @@ int Board::materialCount(Color c, bool endgame) const {
 
 // Returns the number of isolated pawns of the given color
 int Board::getIsolatedPawns(Color c) const {
-    int count = 0;
     Bitboard pawns = getPieces(c, nPawn);
-    while (pawns) {
-        Square sq = pop_lsb(&pawns); 
-        int file = sq & 7;
-        if (file != 0) {
-            if (getPieces(c, nPawn) & (0x0101010101010101 << (file - 1))) {
-                continue; 
-            }
-        }
-        if (file != 7) {
-            if (getPieces(c, nPawn) & (0x0101010101010101 << (file + 1))) {
-                continue; 
-            }
-        }
-        count++;
-    }
-    return count;
+    Bitboard files = fileFill(pawns);
+    return popcount(pawns & ~(shift<EAST>(files) | shift<WEST>(files)));
 }
 
 
-// Returns the number of groups of doubled pawns for the given color
+// Returns the number of doubled pawns of the given color, counting every pawn
+// on a file after the first
 int Board::getDoubledPawns(Color c) const {
-    int count = 0;
     Bitboard pawns = getPieces(c, nPawn);
-    for (int i = 0; i < 8; i++) {
-        Bitboard file = (0x0101010101010101 << i);
-        int onFile = popcount(file & pawns);
-        count += onFile - 1;
-    }
-    return count;
+    return popcount(pawns) - popcount(fileFill(pawns) & Rank1);
 }
 
+
+// Returns the number of backward pawns of the given pawns, whose stop square is
+// attacked by an enemy pawn and can't be defended by a pawn from behind
+template<Color c>
+static int backwardPawns(Bitboard pawns, Bitboard otherPawns) {
+    constexpr Color other = (c == nWhite ? nBlack : nWhite);
+    constexpr Direction up = (c == nWhite ? NORTH : SOUTH);
+    Bitboard attackSpan = frontSpanBB<c>(shift<EAST>(pawns) | shift<WEST>(pawns));
+    return popcount(shift<up>(pawns) & pawnAttacksBB<other>(otherPawns) &
+            ~attackSpan);
+}
+
+
+// Returns the number of backward pawns of the given color
 int Board::getBackwardPawns(Color c) const {
-    Color other = (c == nWhite ? nBlack : nWhite);
     Bitboard pawns = getPieces(c, nPawn);
-    Bitboard attackSpan = 0;
-    Bitboard otherPawns = getPieces(other, nPawn);
-    while (pawns) {
-        Square square = pop_lsb(&pawns);
-        attackSpan |= (pawnFrontSpan[c][square] & ~getFile(square));
-    }
-    Bitboard attacks = (other == nWhite ? pawnAttacksBB<nWhite>(otherPawns) :
-            pawnAttacksBB<nBlack>(otherPawns));
-    int up = (c == nWhite ? 8 : -8);
-    return popcount((getPieces(c, nPawn) << up) & attacks & ~attackSpan);
+    Bitboard otherPawns = getPieces((Color)(c ^ 1), nPawn);
+    return (c == nWhite ? backwardPawns<nWhite>(pawns, otherPawns) :
+            backwardPawns<nBlack>(pawns, otherPawns));
 }
 
 
-// Returns whether a square has a candidate passer or not
-bool Board::isPasser(Square sq) const {
-    if (getPiece(sq) == nPawn) {
-        Color c = getColor(sq);
-        Color other = (c == nWhite ? nBlack : nWhite);
+// Returns the candidate passers among the given pawns. A pawn is one when no
+// enemy pawn is in front of it on its file, and no enemy pawn on its own or the
+// adjacent files stands beyond its next two squares. On the sixth rank it must
+// have no such pawn ahead at all, or be able to advance with at least as many
+// pawns defending its stop square as attacking it and have none beyond that.
+template<Color c>
+static Bitboard candidatePassers(Bitboard pawns, Bitboard otherPawns) {
+    constexpr Color other = (c == nWhite ? nBlack : nWhite);
+    constexpr Direction down = (c == nWhite ? SOUTH : NORTH);
+    constexpr Direction upLeft = (c == nWhite ? NORTH_WEST : SOUTH_WEST);
+    constexpr Direction upRight = (c == nWhite ? NORTH_EAST : SOUTH_EAST);
+    constexpr Direction downLeft = (c == nWhite ? SOUTH_WEST : NORTH_WEST);
+    constexpr Direction downRight = (c == nWhite ? SOUTH_EAST : NORTH_EAST);
+    Bitboard farRanks = (c == nWhite ? Rank2 | Rank3 | Rank4 | Rank5 :
+            Rank7 | Rank6 | Rank5 | Rank4);
+    Bitboard sixthRank = (c == nWhite ? Rank6 : Rank3);
+    Bitboard seventhRank = (c == nWhite ? Rank7 : Rank2);
+
+    // squares with an enemy pawn in front on the same file, and on the same or
+    // the adjacent files
+    Bitboard fileBlocked = frontSpanBB<other>(otherPawns);
+    Bitboard blocked = fileBlocked | shift<EAST>(fileBlocked) |
+        shift<WEST>(fileBlocked);
+
+    // stop squares defended by at least as many pawns as attack them
+    Bitboard defendedLeft = shift<upLeft>(pawns);
+    Bitboard defendedRight = shift<upRight>(pawns);
+    Bitboard attackedLeft = shift<downLeft>(otherPawns);
+    Bitboard attackedRight = shift<downRight>(otherPawns);
+    Bitboard supported = ~(attackedLeft | attackedRight) | (defendedLeft &
+            defendedRight) | ((defendedLeft | defendedRight) & ~(attackedLeft &
+            attackedRight));
+
+    Bitboard open = pawns & ~fileBlocked;
+    return (open & farRanks & ~shift<down>(shift<down>(blocked))) |
+        (open & sixthRank & (~blocked | shift<down>(supported & ~blocked))) |
+        (pawns & seventhRank & ~blocked);
+}
+
 
-        if (!(pawnFrontSpan[c][sq] & getPieces(other, nPawn))) {
-            return true;
-        }
+// Returns the candidate passers of the given color
+Bitboard Board::getPassers(Color c) const {
+    Bitboard pawns = getPieces(c, nPawn);
+    Bitboard otherPawns = getPieces((Color)(c ^ 1), nPawn);
+    return (c == nWhite ? candidatePassers<nWhite>(pawns, otherPawns) :
+            candidatePassers<nBlack>(pawns, otherPawns));
+}
 
-        if (getFile(sq) & pawnFrontSpan[c][sq] &
-                getPieces(other, nPawn)) { // no pawn on same file
-            return false; 
-        }
 
-        int up = (c == nWhite ? 8 : -8);
+// Evaluates the board's pawns into the given pawn table entry
+void Board::evalPawns(PawnEntry& entry) const {
+    entry.key = getPawnZobrist();
+    entry.passers[nWhite] = getPassers(nWhite);
+    entry.passers[nBlack] = getPassers(nBlack);
+    entry.score = -12 * (getIsolatedPawns(nWhite) - getIsolatedPawns(nBlack));
+    entry.score -= 15 * (getBackwardPawns(nWhite) - getBackwardPawns(nBlack));
+    entry.score -= 18 * (getDoubledPawns(nWhite) - getDoubledPawns(nBlack));
+}
 
-        sq = (Square)((int)sq + up);
-        if (sq > H1 && sq < A8) {
-            int support = popcount(pawnAttacks[other][sq] & getPieces(c,
-                        nPawn));
-            int enemies = popcount(pawnAttacks[c][sq] & getPieces(other,
-                        nPawn));
 
-            if (support >= enemies) {
-                if (!(pawnFrontSpan[c][sq] & getPieces(other, nPawn))) {
-                    return true;
-                }
-            }
-            sq = (Square)((int)sq + up);
-            if (sq > H1 && sq < A8) {
-                return !(pawnFrontSpan[c][sq] & getPieces(other, nPawn));
-            }
-        }
+// Returns the pawn table entry for the board's pawns, evaluating them if the
+// table does not hold them
+const PawnEntry& Board::pawnEntry(PawnTable& pawnTable) const {
+    unsigned long long key = getPawnZobrist();
+    bool found;
+    PawnEntry& entry = pawnTable.probe(key, found);
+    if (!found) {
+        evalPawns(entry);
     }
-    return false;
+    return entry;
 }
 
 
-// Returns the passed pawn score for the given color
-int Board::passedScore(Color c) const {
+// Returns the passed pawn score for the given color and its passers
+int Board::passedScore(Color c, Bitboard passers) const {
     int score = 0;
-    int up = (c == nWhite ? 8 : -8);
     Color other = (c == nWhite ? nBlack : nWhite);
 
-    Bitboard pawns = getPieces(c, nPawn);
-    while (pawns != 0) {
-        Square square = pop_lsb(&pawns);
-        if (isPasser(square)) {
-            int rank = square / 8;
-            if (c == nBlack) rank = 7 - rank;
-            score += passedRank[rank];
-            score += min(square % 8 + 1, 8 - square % 8);
-
-            // TODO: Add static exchange evaluation for bonus
-            if (getFile(square) & (getPieces(c, nRook) |
-                        getPieces(c, nQueen)) & pawnFrontSpan[other][square]) {
-                score += passedRank[rank] * 0.17;
-            } 
-            if (getFile(square) & (getPieces(other, nRook) |
-                        getPieces(other, nQueen)) & pawnFrontSpan[other][square]) {
-                score -= passedRank[rank] * 0.17;
-            } 
-            square = (Square)((int)square + up);
-            while (square > H1 && square < A8) {
-                if (getColor(square) == other) {
-                    score -= 5;
-                }
-                square = (Square)((int)square + up);
-            }
-        }
+    while (passers != 0) {
+        Square square = pop_lsb(&passers);
+        int rank = square / 8;
+        if (c == nBlack) rank = 7 - rank;
+        score += passedRank[rank];
+        score += min(square % 8 + 1, 8 - square % 8);
+
+        // TODO: Add static exchange evaluation for bonus
+        if (getFile(square) & (getPieces(c, nRook) |
+                    getPieces(c, nQueen)) & pawnFrontSpan[other][square]) {
+            score += passedRank[rank] * 0.17;
+        } 
+        if (getFile(square) & (getPieces(other, nRook) |
+                    getPieces(other, nQueen)) & pawnFrontSpan[other][square]) {
+            score -= passedRank[rank] * 0.17;
+        } 
+        score -= 5 * popcount(getFile(square) & pawnFrontSpan[c][square] &
+                getPieces(other) & ~(Rank1 | Rank8));
     }
     return score;
 }
 
 
-// Returns the mobility score for the given color
-int Board::mobilityScore(Color c) const {
-    int count = 0;
-    for (int sq = A1; sq <= H8; sq++) {
-        if (getColor(sq) == c) {
-            Piece p = getPiece(sq);
-            Bitboard attacks;
-            if (p == nKnight) {
-                attacks = knightAttacks[sq];
-            } else if (p == nBishop) {
-                attacks = slidingAttacksBB<nBishop>(sq, occupiedBB);
-            } else if (p == nRook) {
-                attacks = slidingAttacksBB<nRook>(sq, occupiedBB);
-            } else if (p == nQueen) {
-                attacks = slidingAttacksBB<nQueen>(sq, occupiedBB);
-            } else {
-                continue;
-            }
-            attacks &= ~(getPieces(c, nKing) | getPieces(c, nPawn));
-            if (c == nWhite) {
-                attacks &= ~(shift<SOUTH_EAST>(getBlackPawns()));
-                attacks &= ~(shift<SOUTH_WEST>(getBlackPawns()));
-            } else if (c == nBlack) {
-                attacks &= ~(shift<NORTH_EAST>(getWhitePawns()));
-                attacks &= ~(shift<NORTH_WEST>(getWhitePawns()));
-            }
-
-            if (p == nKnight) {
-                count += knightMob[popcount(attacks)];
-            } else if (p == nBishop) {
-                count += bishopMob[popcount(attacks)];
-            } else if (p == nRook) {
-                count += rookMob[popcount(attacks)];
-            } else { // queen
-                count += queenMob[popcount(attacks)];
-            }
+// Fills in the attacks of both colors, with the mobility and king zone attacks
+// they give
+void Board::getAttackInfo(AttackInfo& info) const {
+    info.attacks[nWhite][nPawn] = pawnAttacksBB<nWhite>(getPieces(nWhite, nPawn));
+    info.attacks[nBlack][nPawn] = pawnAttacksBB<nBlack>(getPieces(nBlack, nPawn));
+    for (int c = nWhite; c <= nBlack; c++) {
+        Bitboard king = kingAttacks[lsb(getPieces((Color)c, nKing))];
+        info.attacks[c][nKing] = king;
+        info.kingZone[c] = king | (c == nWhite ? shift<NORTH>(king) :
+                shift<SOUTH>(king));
+        for (int p = nKnight; p <= nQueen; p++) {
+            info.attacks[c][p] = 0;
         }
+        info.mobility[c] = 0;
+        info.kingAttacks[c] = 0;
     }
 
-    return count;
+    addPieceAttacks<nWhite, nKnight>(info);
+    addPieceAttacks<nWhite, nBishop>(info);
+    addPieceAttacks<nWhite, nRook>(info);
+    addPieceAttacks<nWhite, nQueen>(info);
+    addPieceAttacks<nBlack, nKnight>(info);
+    addPieceAttacks<nBlack, nBishop>(info);
+    addPieceAttacks<nBlack, nRook>(info);
+    addPieceAttacks<nBlack, nQueen>(info);
 }
 
 
-// Returns the king safety score for the given color
-int Board::safetyScore(Color c) const {
-    int count = 0;
-    Color opp = (c == nWhite ? nBlack : nWhite);
-    int up = (c == nWhite ? 8 : -8);
-
-    int kingSquare = lsb(getPieces(c, nKing));
-    Bitboard kingZone = kingAttacks[kingSquare] | (kingAttacks[kingSquare] << up);
-    kingSquare ^= sqToBB[kingSquare];
-
-    while (kingZone) {
-        Square square = pop_lsb(&kingZone);
-        Bitboard attackers = getAttackers(square, opp);
-
-        while (attackers) {
-            Square attackSq = pop_lsb(&attackers);
-            Piece p = getPiece(attackSq);
-            if (p == nKnight || p == nBishop) {
-                count += 2;
-            } else if (p == nRook) {
-                count += 3;
-            } else if (p == nQueen) {
-                count += 5;
-            }
-        }
+// Adds the attacks of the given color's pieces of the given type to the attack
+// info. Mobility counts the attacked squares not held by the color's own pawns
+// or king or attacked by enemy pawns, and each attack on the enemy king zone
+// counts 2 for a minor piece, 3 for a rook and 5 for a queen.
+template<Color c, Piece p>
+void Board::addPieceAttacks(AttackInfo& info) const {
+    constexpr Color other = (c == nWhite ? nBlack : nWhite);
+    constexpr int weight = (p == nQueen ? 5 : (p == nRook ? 3 : 2));
+    const int* mobility = (p == nKnight ? knightMob : (p == nBishop ? bishopMob :
+                (p == nRook ? rookMob : queenMob)));
+    Bitboard safe = ~(getPieces(c, nKing) | getPieces(c, nPawn) |
+            info.attacks[other][nPawn]);
+
+    Bitboard pieces = getPieces(c, p);
+    while (pieces) {
+        Square sq = pop_lsb(&pieces);
+        Bitboard attacks = (p == nKnight ? knightAttacks[sq] :
+                slidingAttacksBB<p>(sq, occupiedBB));
+        info.attacks[c][p] |= attacks;
+        info.mobility[c] += mobility[popcount(attacks & safe)];
+        info.kingAttacks[other] += weight * popcount(attacks &
+                info.kingZone[other]);
     }
+}
 
-    return -safetyTable[count];
-}
\ No newline at end of file
+
+// Returns the king safety score for the given color
+int Board::safetyScore(const AttackInfo& info, Color c) const {
+    return -safetyTable[std::min(info.kingAttacks[c], 99)];
+}
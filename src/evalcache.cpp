@@ -0,0 +1,38 @@
+#include "evalcache.hpp"
+
+EvalCache evalCache;
+
+// Constructs a new cache of the default size
+EvalCache::EvalCache() {
+    mask = 0;
+    resize(EVAL_CACHE_DEFAULT_MB);
+}
+
+
+// Resizes the cache to the largest power of two number of entries that fits in
+// the given number of megabytes, clearing it
+void EvalCache::resize(size_t mb) {
+    size_t count = (mb << 20) / sizeof(unsigned long long);
+    size_t entries = 1;
+    while (2 * entries <= count) {
+        entries *= 2;
+    }
+
+    table = std::make_unique<std::atomic<unsigned long long>[]>(entries);
+    mask = entries - 1;
+    clear();
+}
+
+
+// Empties every entry of the cache
+void EvalCache::clear() {
+    for (size_t i = 0; i <= mask; i++) {
+        table[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+
+// Returns the size of the cache in megabytes
+size_t EvalCache::getSize() const {
+    return ((mask + 1) * sizeof(unsigned long long)) >> 20;
+}
@@ -0,0 +1,100 @@
+#include "largepages.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+
+// Returns the size rounded up to a whole number of large pages
+static size_t roundToPages(size_t size) {
+    return (size + LARGE_PAGE_SIZE - 1) & ~(LARGE_PAGE_SIZE - 1);
+}
+
+
+#ifdef __linux__
+// Returns whether transparent huge pages are turned off for the system
+static bool transparentDisabled() {
+    std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+    std::string setting;
+    std::getline(file, setting);
+    return !file || setting.find("[never]") != std::string::npos;
+}
+#endif
+
+
+// Allocates zeroed memory for a large table. Explicit huge pages from the
+// hugetlbfs pool are tried first. Otherwise normal pages are mapped on a 2 MB
+// boundary and the kernel is asked to back them with transparent huge pages.
+void* largeAlloc(size_t size, PageMode* mode) {
+    size_t rounded = roundToPages(size);
+#ifdef __linux__
+    void* mem = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE |
+            MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (mem != MAP_FAILED) {
+        *mode = PAGES_HUGETLB;
+        return mem;
+    }
+
+    // map an extra page so the table can start on a large page boundary, then
+    // return the unused head and tail to the system
+    char* raw = (char*)mmap(nullptr, rounded + LARGE_PAGE_SIZE, PROT_READ |
+            PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    char* aligned = (char*)roundToPages((uintptr_t)raw);
+    if (aligned != raw) {
+        munmap(raw, aligned - raw);
+    }
+    munmap(aligned + rounded, raw + LARGE_PAGE_SIZE - aligned);
+
+    if (!transparentDisabled() && madvise(aligned, rounded, MADV_HUGEPAGE) == 0) {
+        *mode = PAGES_TRANSPARENT;
+    } else {
+        *mode = PAGES_NORMAL;
+    }
+    return aligned;
+#else
+    void* mem = std::aligned_alloc(LARGE_PAGE_SIZE, rounded);
+    if (mem == nullptr) {
+        throw std::bad_alloc();
+    }
+    std::memset(mem, 0, rounded);
+    *mode = PAGES_NORMAL;
+    return mem;
+#endif
+}
+
+
+// Frees memory of the given size allocated by largeAlloc
+void largeFree(void* mem, size_t size) {
+    if (mem == nullptr) {
+        return;
+    }
+#ifdef __linux__
+    munmap(mem, roundToPages(size));
+#else
+    std::free(mem);
+#endif
+}
+
+
+// Returns a readable name for the page mode
+const char* pageModeName(PageMode mode) {
+    switch (mode) {
+        case PAGES_HUGETLB:
+            return "huge pages";
+        case PAGES_TRANSPARENT:
+            return "transparent huge pages";
+        case PAGES_MAPPED:
+            return "a mapped file";
+        default:
+            return "normal pages";
+    }
+}
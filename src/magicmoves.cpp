@@ -50,7 +50,7 @@
 //C64(0x007FFCDDFCED714A) - B8 10 bit
 //C64(0x003FFFCDFFD88096) - C8 10 bit
 
-const unsigned int magicmoves_r_shift[64]=
+constexpr unsigned int magicmoves_r_shift[64]=
 {
 	52, 53, 53, 53, 53, 53, 53, 52,
 	53, 54, 54, 54, 54, 54, 54, 53,
@@ -62,7 +62,7 @@ const unsigned int magicmoves_r_shift[64]=
 	53, 54, 54, 53, 53, 53, 53, 53
 };
 
-const U64 magicmoves_r_magics[64]=
+constexpr U64 magicmoves_r_magics[64]=
 {
 	C64(0x0080001020400080), C64(0x0040001000200040), C64(0x0080081000200080), C64(0x0080040800100080),
 	C64(0x0080020400080080), C64(0x0080010200040080), C64(0x0080008001000200), C64(0x0080002040800100),
@@ -81,7 +81,7 @@ const U64 magicmoves_r_magics[64]=
 	C64(0x00FFFCDDFCED714A), C64(0x007FFCDDFCED714A), C64(0x003FFFCDFFD88096), C64(0x0000040810002101),
 	C64(0x0001000204080011), C64(0x0001000204000801), C64(0x0001000082000401), C64(0x0001FFFAABFAD1A2)
 };
-const U64 magicmoves_r_mask[64]=
+constexpr U64 magicmoves_r_mask[64]=
 {	
 	C64(0x000101010101017E), C64(0x000202020202027C), C64(0x000404040404047A), C64(0x0008080808080876),
 	C64(0x001010101010106E), C64(0x002020202020205E), C64(0x004040404040403E), C64(0x008080808080807E),
@@ -102,7 +102,7 @@ const U64 magicmoves_r_mask[64]=
 };
 
 //my original tables for bishops
-const unsigned int magicmoves_b_shift[64]=
+constexpr unsigned int magicmoves_b_shift[64]=
 {
 	58, 59, 59, 59, 59, 59, 59, 58,
 	59, 59, 59, 59, 59, 59, 59, 59,
@@ -114,7 +114,7 @@ const unsigned int magicmoves_b_shift[64]=
 	58, 59, 59, 59, 59, 59, 59, 58
 };
 
-const U64 magicmoves_b_magics[64]=
+constexpr U64 magicmoves_b_magics[64]=
 {
 	C64(0x0002020202020200), C64(0x0002020202020000), C64(0x0004010202000000), C64(0x0004040080000000),
 	C64(0x0001104000000000), C64(0x0000821040000000), C64(0x0000410410400000), C64(0x0000104104104000),
@@ -135,7 +135,7 @@ const U64 magicmoves_b_magics[64]=
 };
 
 
-const U64 magicmoves_b_mask[64]=
+constexpr U64 magicmoves_b_mask[64]=
 {
 	C64(0x0040201008040200), C64(0x0000402010080400), C64(0x0000004020100A00), C64(0x0000000040221400),
 	C64(0x0000000002442800), C64(0x0000000204085000), C64(0x0000020408102000), C64(0x0002040810204000),
@@ -156,25 +156,17 @@ const U64 magicmoves_b_mask[64]=
 };
 
 #ifdef MINIMIZE_MAGIC
-U64 magicmovesbdb[5248];
-const U64* magicmoves_b_indices[64]=
+//offset of each square's moves in the database
+static constexpr unsigned int magicmoves_b_offsets[64]=
 {
-	magicmovesbdb+4992, magicmovesbdb+2624,  magicmovesbdb+256,  magicmovesbdb+896,
-	magicmovesbdb+1280, magicmovesbdb+1664, magicmovesbdb+4800, magicmovesbdb+5120,
-	magicmovesbdb+2560, magicmovesbdb+2656,  magicmovesbdb+288,  magicmovesbdb+928,
-	magicmovesbdb+1312, magicmovesbdb+1696, magicmovesbdb+4832, magicmovesbdb+4928,
-	magicmovesbdb+0,     magicmovesbdb+128,  magicmovesbdb+320,  magicmovesbdb+960,
-	magicmovesbdb+1344, magicmovesbdb+1728, magicmovesbdb+2304, magicmovesbdb+2432,
-	magicmovesbdb+32,    magicmovesbdb+160,  magicmovesbdb+448, magicmovesbdb+2752,
-	magicmovesbdb+3776, magicmovesbdb+1856, magicmovesbdb+2336, magicmovesbdb+2464,
-	magicmovesbdb+64,    magicmovesbdb+192,  magicmovesbdb+576, magicmovesbdb+3264,
-	magicmovesbdb+4288, magicmovesbdb+1984, magicmovesbdb+2368, magicmovesbdb+2496,
-	magicmovesbdb+96,    magicmovesbdb+224,  magicmovesbdb+704, magicmovesbdb+1088,
-	magicmovesbdb+1472, magicmovesbdb+2112, magicmovesbdb+2400, magicmovesbdb+2528,
-	magicmovesbdb+2592, magicmovesbdb+2688,  magicmovesbdb+832, magicmovesbdb+1216,
-	magicmovesbdb+1600, magicmovesbdb+2240, magicmovesbdb+4864, magicmovesbdb+4960,
-	magicmovesbdb+5056, magicmovesbdb+2720,  magicmovesbdb+864, magicmovesbdb+1248,
-	magicmovesbdb+1632, magicmovesbdb+2272, magicmovesbdb+4896, magicmovesbdb+5184
+	  4992,   2624,    256,    896,   1280,   1664,   4800,   5120,
+	  2560,   2656,    288,    928,   1312,   1696,   4832,   4928,
+	     0,    128,    320,    960,   1344,   1728,   2304,   2432,
+	    32,    160,    448,   2752,   3776,   1856,   2336,   2464,
+	    64,    192,    576,   3264,   4288,   1984,   2368,   2496,
+	    96,    224,    704,   1088,   1472,   2112,   2400,   2528,
+	  2592,   2688,    832,   1216,   1600,   2240,   4864,   4960,
+	  5056,   2720,    864,   1248,   1632,   2272,   4896,   5184
 };
 #else
 	#ifndef PERFECT_MAGIC_HASH
@@ -186,25 +178,17 @@ const U64* magicmoves_b_indices[64]=
 #endif
 
 #ifdef MINIMIZE_MAGIC
-U64 magicmovesrdb[102400];
-const U64* magicmoves_r_indices[64]=
+//offset of each square's moves in the database
+static constexpr unsigned int magicmoves_r_offsets[64]=
 {
-	magicmovesrdb+86016, magicmovesrdb+73728, magicmovesrdb+36864, magicmovesrdb+43008,
-	magicmovesrdb+47104, magicmovesrdb+51200, magicmovesrdb+77824, magicmovesrdb+94208,
-	magicmovesrdb+69632, magicmovesrdb+32768, magicmovesrdb+38912, magicmovesrdb+10240,
-	magicmovesrdb+14336, magicmovesrdb+53248, magicmovesrdb+57344, magicmovesrdb+81920,
-	magicmovesrdb+24576, magicmovesrdb+33792,  magicmovesrdb+6144, magicmovesrdb+11264,
-	magicmovesrdb+15360, magicmovesrdb+18432, magicmovesrdb+58368, magicmovesrdb+61440,
-	magicmovesrdb+26624,  magicmovesrdb+4096,  magicmovesrdb+7168,     magicmovesrdb+0,
-	 magicmovesrdb+2048, magicmovesrdb+19456, magicmovesrdb+22528, magicmovesrdb+63488,
-	magicmovesrdb+28672,  magicmovesrdb+5120,  magicmovesrdb+8192,  magicmovesrdb+1024,
-	 magicmovesrdb+3072, magicmovesrdb+20480, magicmovesrdb+23552, magicmovesrdb+65536,
-	magicmovesrdb+30720, magicmovesrdb+34816,  magicmovesrdb+9216, magicmovesrdb+12288,
-	magicmovesrdb+16384, magicmovesrdb+21504, magicmovesrdb+59392, magicmovesrdb+67584,
-	magicmovesrdb+71680, magicmovesrdb+35840, magicmovesrdb+39936, magicmovesrdb+13312,
-	magicmovesrdb+17408, magicmovesrdb+54272, magicmovesrdb+60416, magicmovesrdb+83968,
-	magicmovesrdb+90112, magicmovesrdb+75776, magicmovesrdb+40960, magicmovesrdb+45056,
-	magicmovesrdb+49152, magicmovesrdb+55296, magicmovesrdb+79872, magicmovesrdb+98304
+	 86016,  73728,  36864,  43008,  47104,  51200,  77824,  94208,
+	 69632,  32768,  38912,  10240,  14336,  53248,  57344,  81920,
+	 24576,  33792,   6144,  11264,  15360,  18432,  58368,  61440,
+	 26624,   4096,   7168,      0,   2048,  19456,  22528,  63488,
+	 28672,   5120,   8192,   1024,   3072,  20480,  23552,  65536,
+	 30720,  34816,   9216,  12288,  16384,  21504,  59392,  67584,
+	 71680,  35840,  39936,  13312,  17408,  54272,  60416,  83968,
+	 90112,  75776,  40960,  45056,  49152,  55296,  79872,  98304
 };
 #else
 	#ifndef PERFECT_MAGIC_HASH
@@ -215,7 +199,7 @@ const U64* magicmoves_r_indices[64]=
 	#endif
 #endif
 
-U64 initmagicmoves_occ(const int* squares, const int numSquares, const U64 linocc)
+constexpr U64 initmagicmoves_occ(const int* squares, const int numSquares, const U64 linocc)
 {
 	int i;
 	U64 ret=0;
@@ -224,7 +208,7 @@ U64 initmagicmoves_occ(const int* squares, const int numSquares, const U64 linoc
 	return ret;
 }
 
-U64 initmagicmoves_Rmoves(const int square, const U64 occ)
+constexpr U64 initmagicmoves_Rmoves(const int square, const U64 occ)
 {
 	U64 ret=0;
 	U64 bit;
@@ -259,7 +243,7 @@ U64 initmagicmoves_Rmoves(const int square, const U64 occ)
 	return ret;
 }
 
-U64 initmagicmoves_Bmoves(const int square, const U64 occ)
+constexpr U64 initmagicmoves_Bmoves(const int square, const U64 occ)
 {
 	U64 ret=0;
 	U64 bit;
@@ -305,13 +289,211 @@ U64 initmagicmoves_Bmoves(const int square, const U64 occ)
 	return ret;
 }
 
+#ifdef MINIMIZE_MAGIC
+//holds a minimized database, which is built at compile time so that it lands
+//in a read-only section and needs no initialization
+template<int size>
+struct initmagicmoves_db
+{
+	U64 moves[size];
+};
+
+//builds a minimized database, storing the moves for every occupancy of each
+//square's mask at the square's offset
+template<int size>
+constexpr initmagicmoves_db<size> initmagicmoves_build(const U64* mask, const U64* magics,
+	const unsigned int* shift, const unsigned int* offsets, U64 (*moves)(const int, const U64))
+{
+	initmagicmoves_db<size> db{};
+	for(int i=0;i<64;i++)
+	{
+		U64 occ=0;
+		do
+		{
+			db.moves[offsets[i]+((occ*magics[i])>>shift[i])]=moves(i,occ);
+			occ=(occ-mask[i])&mask[i];
+		}while(occ);
+	}
+	return db;
+}
+
+static constexpr initmagicmoves_db<5248> magicmovesbdb=initmagicmoves_build<5248>(
+	magicmoves_b_mask,magicmoves_b_magics,magicmoves_b_shift,magicmoves_b_offsets,
+	initmagicmoves_Bmoves);
+static constexpr initmagicmoves_db<102400> magicmovesrdb=initmagicmoves_build<102400>(
+	magicmoves_r_mask,magicmoves_r_magics,magicmoves_r_shift,magicmoves_r_offsets,
+	initmagicmoves_Rmoves);
+
+const U64* const magicmoves_b_indices[64]=
+{
+	magicmovesbdb.moves+magicmoves_b_offsets[0], magicmovesbdb.moves+magicmoves_b_offsets[1], magicmovesbdb.moves+magicmoves_b_offsets[2], magicmovesbdb.moves+magicmoves_b_offsets[3],
+	magicmovesbdb.moves+magicmoves_b_offsets[4], magicmovesbdb.moves+magicmoves_b_offsets[5], magicmovesbdb.moves+magicmoves_b_offsets[6], magicmovesbdb.moves+magicmoves_b_offsets[7],
+	magicmovesbdb.moves+magicmoves_b_offsets[8], magicmovesbdb.moves+magicmoves_b_offsets[9], magicmovesbdb.moves+magicmoves_b_offsets[10], magicmovesbdb.moves+magicmoves_b_offsets[11],
+	magicmovesbdb.moves+magicmoves_b_offsets[12], magicmovesbdb.moves+magicmoves_b_offsets[13], magicmovesbdb.moves+magicmoves_b_offsets[14], magicmovesbdb.moves+magicmoves_b_offsets[15],
+	magicmovesbdb.moves+magicmoves_b_offsets[16], magicmovesbdb.moves+magicmoves_b_offsets[17], magicmovesbdb.moves+magicmoves_b_offsets[18], magicmovesbdb.moves+magicmoves_b_offsets[19],
+	magicmovesbdb.moves+magicmoves_b_offsets[20], magicmovesbdb.moves+magicmoves_b_offsets[21], magicmovesbdb.moves+magicmoves_b_offsets[22], magicmovesbdb.moves+magicmoves_b_offsets[23],
+	magicmovesbdb.moves+magicmoves_b_offsets[24], magicmovesbdb.moves+magicmoves_b_offsets[25], magicmovesbdb.moves+magicmoves_b_offsets[26], magicmovesbdb.moves+magicmoves_b_offsets[27],
+	magicmovesbdb.moves+magicmoves_b_offsets[28], magicmovesbdb.moves+magicmoves_b_offsets[29], magicmovesbdb.moves+magicmoves_b_offsets[30], magicmovesbdb.moves+magicmoves_b_offsets[31],
+	magicmovesbdb.moves+magicmoves_b_offsets[32], magicmovesbdb.moves+magicmoves_b_offsets[33], magicmovesbdb.moves+magicmoves_b_offsets[34], magicmovesbdb.moves+magicmoves_b_offsets[35],
+	magicmovesbdb.moves+magicmoves_b_offsets[36], magicmovesbdb.moves+magicmoves_b_offsets[37], magicmovesbdb.moves+magicmoves_b_offsets[38], magicmovesbdb.moves+magicmoves_b_offsets[39],
+	magicmovesbdb.moves+magicmoves_b_offsets[40], magicmovesbdb.moves+magicmoves_b_offsets[41], magicmovesbdb.moves+magicmoves_b_offsets[42], magicmovesbdb.moves+magicmoves_b_offsets[43],
+	magicmovesbdb.moves+magicmoves_b_offsets[44], magicmovesbdb.moves+magicmoves_b_offsets[45], magicmovesbdb.moves+magicmoves_b_offsets[46], magicmovesbdb.moves+magicmoves_b_offsets[47],
+	magicmovesbdb.moves+magicmoves_b_offsets[48], magicmovesbdb.moves+magicmoves_b_offsets[49], magicmovesbdb.moves+magicmoves_b_offsets[50], magicmovesbdb.moves+magicmoves_b_offsets[51],
+	magicmovesbdb.moves+magicmoves_b_offsets[52], magicmovesbdb.moves+magicmoves_b_offsets[53], magicmovesbdb.moves+magicmoves_b_offsets[54], magicmovesbdb.moves+magicmoves_b_offsets[55],
+	magicmovesbdb.moves+magicmoves_b_offsets[56], magicmovesbdb.moves+magicmoves_b_offsets[57], magicmovesbdb.moves+magicmoves_b_offsets[58], magicmovesbdb.moves+magicmoves_b_offsets[59],
+	magicmovesbdb.moves+magicmoves_b_offsets[60], magicmovesbdb.moves+magicmoves_b_offsets[61], magicmovesbdb.moves+magicmoves_b_offsets[62], magicmovesbdb.moves+magicmoves_b_offsets[63]
+};
+const U64* const magicmoves_r_indices[64]=
+{
+	magicmovesrdb.moves+magicmoves_r_offsets[0], magicmovesrdb.moves+magicmoves_r_offsets[1], magicmovesrdb.moves+magicmoves_r_offsets[2], magicmovesrdb.moves+magicmoves_r_offsets[3],
+	magicmovesrdb.moves+magicmoves_r_offsets[4], magicmovesrdb.moves+magicmoves_r_offsets[5], magicmovesrdb.moves+magicmoves_r_offsets[6], magicmovesrdb.moves+magicmoves_r_offsets[7],
+	magicmovesrdb.moves+magicmoves_r_offsets[8], magicmovesrdb.moves+magicmoves_r_offsets[9], magicmovesrdb.moves+magicmoves_r_offsets[10], magicmovesrdb.moves+magicmoves_r_offsets[11],
+	magicmovesrdb.moves+magicmoves_r_offsets[12], magicmovesrdb.moves+magicmoves_r_offsets[13], magicmovesrdb.moves+magicmoves_r_offsets[14], magicmovesrdb.moves+magicmoves_r_offsets[15],
+	magicmovesrdb.moves+magicmoves_r_offsets[16], magicmovesrdb.moves+magicmoves_r_offsets[17], magicmovesrdb.moves+magicmoves_r_offsets[18], magicmovesrdb.moves+magicmoves_r_offsets[19],
+	magicmovesrdb.moves+magicmoves_r_offsets[20], magicmovesrdb.moves+magicmoves_r_offsets[21], magicmovesrdb.moves+magicmoves_r_offsets[22], magicmovesrdb.moves+magicmoves_r_offsets[23],
+	magicmovesrdb.moves+magicmoves_r_offsets[24], magicmovesrdb.moves+magicmoves_r_offsets[25], magicmovesrdb.moves+magicmoves_r_offsets[26], magicmovesrdb.moves+magicmoves_r_offsets[27],
+	magicmovesrdb.moves+magicmoves_r_offsets[28], magicmovesrdb.moves+magicmoves_r_offsets[29], magicmovesrdb.moves+magicmoves_r_offsets[30], magicmovesrdb.moves+magicmoves_r_offsets[31],
+	magicmovesrdb.moves+magicmoves_r_offsets[32], magicmovesrdb.moves+magicmoves_r_offsets[33], magicmovesrdb.moves+magicmoves_r_offsets[34], magicmovesrdb.moves+magicmoves_r_offsets[35],
+	magicmovesrdb.moves+magicmoves_r_offsets[36], magicmovesrdb.moves+magicmoves_r_offsets[37], magicmovesrdb.moves+magicmoves_r_offsets[38], magicmovesrdb.moves+magicmoves_r_offsets[39],
+	magicmovesrdb.moves+magicmoves_r_offsets[40], magicmovesrdb.moves+magicmoves_r_offsets[41], magicmovesrdb.moves+magicmoves_r_offsets[42], magicmovesrdb.moves+magicmoves_r_offsets[43],
+	magicmovesrdb.moves+magicmoves_r_offsets[44], magicmovesrdb.moves+magicmoves_r_offsets[45], magicmovesrdb.moves+magicmoves_r_offsets[46], magicmovesrdb.moves+magicmoves_r_offsets[47],
+	magicmovesrdb.moves+magicmoves_r_offsets[48], magicmovesrdb.moves+magicmoves_r_offsets[49], magicmovesrdb.moves+magicmoves_r_offsets[50], magicmovesrdb.moves+magicmoves_r_offsets[51],
+	magicmovesrdb.moves+magicmoves_r_offsets[52], magicmovesrdb.moves+magicmoves_r_offsets[53], magicmovesrdb.moves+magicmoves_r_offsets[54], magicmovesrdb.moves+magicmoves_r_offsets[55],
+	magicmovesrdb.moves+magicmoves_r_offsets[56], magicmovesrdb.moves+magicmoves_r_offsets[57], magicmovesrdb.moves+magicmoves_r_offsets[58], magicmovesrdb.moves+magicmoves_r_offsets[59],
+	magicmovesrdb.moves+magicmoves_r_offsets[60], magicmovesrdb.moves+magicmoves_r_offsets[61], magicmovesrdb.moves+magicmoves_r_offsets[62], magicmovesrdb.moves+magicmoves_r_offsets[63]
+};
+
+//shared-entry layout: each square keeps each of its distinct move bitboards
+//once, and the magic index picks a one byte reference to one of them. The
+//references and the 6328 move bitboards take 155kb, against the 841kb of the
+//minimized databases.
+template<int nrefs, int nsets>
+struct initmagicmoves_shared
+{
+	unsigned char refs[nrefs];
+	U64 sets[nsets];
+	unsigned int setoffsets[64];
+	int used;
+};
+
+//builds a shared-entry layout, numbering each square's distinct move
+//bitboards in the order they are first met
+template<int nrefs, int nsets>
+constexpr initmagicmoves_shared<nrefs,nsets> initmagicmoves_build_shared(const U64* mask,
+	const U64* magics, const unsigned int* shift, const unsigned int* offsets,
+	U64 (*moves)(const int, const U64))
+{
+	initmagicmoves_shared<nrefs,nsets> db{};
+	for(int i=0;i<64;i++)
+	{
+		int count=0;
+		U64 occ=0;
+		db.setoffsets[i]=db.used;
+		do
+		{
+			U64 m=moves(i,occ);
+			int j=0;
+			while(j<count && db.sets[db.used+j]!=m) j++;
+			if(j==count) db.sets[db.used+count++]=m;
+			db.refs[offsets[i]+((occ*magics[i])>>shift[i])]=j;
+			occ=(occ-mask[i])&mask[i];
+		}while(occ);
+		db.used+=count;
+	}
+	return db;
+}
+
+static constexpr initmagicmoves_shared<5248,1428> magicmovesbshared=initmagicmoves_build_shared<5248,1428>(
+	magicmoves_b_mask,magicmoves_b_magics,magicmoves_b_shift,magicmoves_b_offsets,
+	initmagicmoves_Bmoves);
+static constexpr initmagicmoves_shared<102400,4900> magicmovesrshared=initmagicmoves_build_shared<102400,4900>(
+	magicmoves_r_mask,magicmoves_r_magics,magicmoves_r_shift,magicmoves_r_offsets,
+	initmagicmoves_Rmoves);
+static_assert(magicmovesbshared.used==1428 && magicmovesrshared.used==4900,
+	"magicmoves - the shared move tables must be filled exactly");
+
+const unsigned char* const magicmoves_b_shared_refs[64]=
+{
+	magicmovesbshared.refs+magicmoves_b_offsets[0], magicmovesbshared.refs+magicmoves_b_offsets[1], magicmovesbshared.refs+magicmoves_b_offsets[2], magicmovesbshared.refs+magicmoves_b_offsets[3],
+	magicmovesbshared.refs+magicmoves_b_offsets[4], magicmovesbshared.refs+magicmoves_b_offsets[5], magicmovesbshared.refs+magicmoves_b_offsets[6], magicmovesbshared.refs+magicmoves_b_offsets[7],
+	magicmovesbshared.refs+magicmoves_b_offsets[8], magicmovesbshared.refs+magicmoves_b_offsets[9], magicmovesbshared.refs+magicmoves_b_offsets[10], magicmovesbshared.refs+magicmoves_b_offsets[11],
+	magicmovesbshared.refs+magicmoves_b_offsets[12], magicmovesbshared.refs+magicmoves_b_offsets[13], magicmovesbshared.refs+magicmoves_b_offsets[14], magicmovesbshared.refs+magicmoves_b_offsets[15],
+	magicmovesbshared.refs+magicmoves_b_offsets[16], magicmovesbshared.refs+magicmoves_b_offsets[17], magicmovesbshared.refs+magicmoves_b_offsets[18], magicmovesbshared.refs+magicmoves_b_offsets[19],
+	magicmovesbshared.refs+magicmoves_b_offsets[20], magicmovesbshared.refs+magicmoves_b_offsets[21], magicmovesbshared.refs+magicmoves_b_offsets[22], magicmovesbshared.refs+magicmoves_b_offsets[23],
+	magicmovesbshared.refs+magicmoves_b_offsets[24], magicmovesbshared.refs+magicmoves_b_offsets[25], magicmovesbshared.refs+magicmoves_b_offsets[26], magicmovesbshared.refs+magicmoves_b_offsets[27],
+	magicmovesbshared.refs+magicmoves_b_offsets[28], magicmovesbshared.refs+magicmoves_b_offsets[29], magicmovesbshared.refs+magicmoves_b_offsets[30], magicmovesbshared.refs+magicmoves_b_offsets[31],
+	magicmovesbshared.refs+magicmoves_b_offsets[32], magicmovesbshared.refs+magicmoves_b_offsets[33], magicmovesbshared.refs+magicmoves_b_offsets[34], magicmovesbshared.refs+magicmoves_b_offsets[35],
+	magicmovesbshared.refs+magicmoves_b_offsets[36], magicmovesbshared.refs+magicmoves_b_offsets[37], magicmovesbshared.refs+magicmoves_b_offsets[38], magicmovesbshared.refs+magicmoves_b_offsets[39],
+	magicmovesbshared.refs+magicmoves_b_offsets[40], magicmovesbshared.refs+magicmoves_b_offsets[41], magicmovesbshared.refs+magicmoves_b_offsets[42], magicmovesbshared.refs+magicmoves_b_offsets[43],
+	magicmovesbshared.refs+magicmoves_b_offsets[44], magicmovesbshared.refs+magicmoves_b_offsets[45], magicmovesbshared.refs+magicmoves_b_offsets[46], magicmovesbshared.refs+magicmoves_b_offsets[47],
+	magicmovesbshared.refs+magicmoves_b_offsets[48], magicmovesbshared.refs+magicmoves_b_offsets[49], magicmovesbshared.refs+magicmoves_b_offsets[50], magicmovesbshared.refs+magicmoves_b_offsets[51],
+	magicmovesbshared.refs+magicmoves_b_offsets[52], magicmovesbshared.refs+magicmoves_b_offsets[53], magicmovesbshared.refs+magicmoves_b_offsets[54], magicmovesbshared.refs+magicmoves_b_offsets[55],
+	magicmovesbshared.refs+magicmoves_b_offsets[56], magicmovesbshared.refs+magicmoves_b_offsets[57], magicmovesbshared.refs+magicmoves_b_offsets[58], magicmovesbshared.refs+magicmoves_b_offsets[59],
+	magicmovesbshared.refs+magicmoves_b_offsets[60], magicmovesbshared.refs+magicmoves_b_offsets[61], magicmovesbshared.refs+magicmoves_b_offsets[62], magicmovesbshared.refs+magicmoves_b_offsets[63]
+};
+const U64* const magicmoves_b_shared_sets[64]=
+{
+	magicmovesbshared.sets+magicmovesbshared.setoffsets[0], magicmovesbshared.sets+magicmovesbshared.setoffsets[1], magicmovesbshared.sets+magicmovesbshared.setoffsets[2], magicmovesbshared.sets+magicmovesbshared.setoffsets[3],
+	magicmovesbshared.sets+magicmovesbshared.setoffsets[4], magicmovesbshared.sets+magicmovesbshared.setoffsets[5], magicmovesbshared.sets+magicmovesbshared.setoffsets[6], magicmovesbshared.sets+magicmovesbshared.setoffsets[7],
+	magicmovesbshared.sets+magicmovesbshared.setoffsets[8], magicmovesbshared.sets+magicmovesbshared.setoffsets[9], magicmovesbshared.sets+magicmovesbshared.setoffsets[10], magicmovesbshared.sets+magicmovesbshared.setoffsets[11],
+	magicmovesbshared.sets+magicmovesbshared.setoffsets[12], magicmovesbshared.sets+magicmovesbshared.setoffsets[13], magicmovesbshared.sets+magicmovesbshared.setoffsets[14], magicmovesbshared.sets+magicmovesbshared.setoffsets[15],
+	magicmovesbshared.sets+magicmovesbshared.setoffsets[16], magicmovesbshared.sets+magicmovesbshared.setoffsets[17], magicmovesbshared.sets+magicmovesbshared.setoffsets[18], magicmovesbshared.sets+magicmovesbshared.setoffsets[19],
+	magicmovesbshared.sets+magicmovesbshared.setoffsets[20], magicmovesbshared.sets+magicmovesbshared.setoffsets[21], magicmovesbshared.sets+magicmovesbshared.setoffsets[22], magicmovesbshared.sets+magicmovesbshared.setoffsets[23],
+	magicmovesbshared.sets+magicmovesbshared.setoffsets[24], magicmovesbshared.sets+magicmovesbshared.setoffsets[25], magicmovesbshared.sets+magicmovesbshared.setoffsets[26], magicmovesbshared.sets+magicmovesbshared.setoffsets[27],
+	magicmovesbshared.sets+magicmovesbshared.setoffsets[28], magicmovesbshared.sets+magicmovesbshared.setoffsets[29], magicmovesbshared.sets+magicmovesbshared.setoffsets[30], magicmovesbshared.sets+magicmovesbshared.setoffsets[31],
+	magicmovesbshared.sets+magicmovesbshared.setoffsets[32], magicmovesbshared.sets+magicmovesbshared.setoffsets[33], magicmovesbshared.sets+magicmovesbshared.setoffsets[34], magicmovesbshared.sets+magicmovesbshared.setoffsets[35],
+	magicmovesbshared.sets+magicmovesbshared.setoffsets[36], magicmovesbshared.sets+magicmovesbshared.setoffsets[37], magicmovesbshared.sets+magicmovesbshared.setoffsets[38], magicmovesbshared.sets+magicmovesbshared.setoffsets[39],
+	magicmovesbshared.sets+magicmovesbshared.setoffsets[40], magicmovesbshared.sets+magicmovesbshared.setoffsets[41], magicmovesbshared.sets+magicmovesbshared.setoffsets[42], magicmovesbshared.sets+magicmovesbshared.setoffsets[43],
+	magicmovesbshared.sets+magicmovesbshared.setoffsets[44], magicmovesbshared.sets+magicmovesbshared.setoffsets[45], magicmovesbshared.sets+magicmovesbshared.setoffsets[46], magicmovesbshared.sets+magicmovesbshared.setoffsets[47],
+	magicmovesbshared.sets+magicmovesbshared.setoffsets[48], magicmovesbshared.sets+magicmovesbshared.setoffsets[49], magicmovesbshared.sets+magicmovesbshared.setoffsets[50], magicmovesbshared.sets+magicmovesbshared.setoffsets[51],
+	magicmovesbshared.sets+magicmovesbshared.setoffsets[52], magicmovesbshared.sets+magicmovesbshared.setoffsets[53], magicmovesbshared.sets+magicmovesbshared.setoffsets[54], magicmovesbshared.sets+magicmovesbshared.setoffsets[55],
+	magicmovesbshared.sets+magicmovesbshared.setoffsets[56], magicmovesbshared.sets+magicmovesbshared.setoffsets[57], magicmovesbshared.sets+magicmovesbshared.setoffsets[58], magicmovesbshared.sets+magicmovesbshared.setoffsets[59],
+	magicmovesbshared.sets+magicmovesbshared.setoffsets[60], magicmovesbshared.sets+magicmovesbshared.setoffsets[61], magicmovesbshared.sets+magicmovesbshared.setoffsets[62], magicmovesbshared.sets+magicmovesbshared.setoffsets[63]
+};
+const unsigned char* const magicmoves_r_shared_refs[64]=
+{
+	magicmovesrshared.refs+magicmoves_r_offsets[0], magicmovesrshared.refs+magicmoves_r_offsets[1], magicmovesrshared.refs+magicmoves_r_offsets[2], magicmovesrshared.refs+magicmoves_r_offsets[3],
+	magicmovesrshared.refs+magicmoves_r_offsets[4], magicmovesrshared.refs+magicmoves_r_offsets[5], magicmovesrshared.refs+magicmoves_r_offsets[6], magicmovesrshared.refs+magicmoves_r_offsets[7],
+	magicmovesrshared.refs+magicmoves_r_offsets[8], magicmovesrshared.refs+magicmoves_r_offsets[9], magicmovesrshared.refs+magicmoves_r_offsets[10], magicmovesrshared.refs+magicmoves_r_offsets[11],
+	magicmovesrshared.refs+magicmoves_r_offsets[12], magicmovesrshared.refs+magicmoves_r_offsets[13], magicmovesrshared.refs+magicmoves_r_offsets[14], magicmovesrshared.refs+magicmoves_r_offsets[15],
+	magicmovesrshared.refs+magicmoves_r_offsets[16], magicmovesrshared.refs+magicmoves_r_offsets[17], magicmovesrshared.refs+magicmoves_r_offsets[18], magicmovesrshared.refs+magicmoves_r_offsets[19],
+	magicmovesrshared.refs+magicmoves_r_offsets[20], magicmovesrshared.refs+magicmoves_r_offsets[21], magicmovesrshared.refs+magicmoves_r_offsets[22], magicmovesrshared.refs+magicmoves_r_offsets[23],
+	magicmovesrshared.refs+magicmoves_r_offsets[24], magicmovesrshared.refs+magicmoves_r_offsets[25], magicmovesrshared.refs+magicmoves_r_offsets[26], magicmovesrshared.refs+magicmoves_r_offsets[27],
+	magicmovesrshared.refs+magicmoves_r_offsets[28], magicmovesrshared.refs+magicmoves_r_offsets[29], magicmovesrshared.refs+magicmoves_r_offsets[30], magicmovesrshared.refs+magicmoves_r_offsets[31],
+	magicmovesrshared.refs+magicmoves_r_offsets[32], magicmovesrshared.refs+magicmoves_r_offsets[33], magicmovesrshared.refs+magicmoves_r_offsets[34], magicmovesrshared.refs+magicmoves_r_offsets[35],
+	magicmovesrshared.refs+magicmoves_r_offsets[36], magicmovesrshared.refs+magicmoves_r_offsets[37], magicmovesrshared.refs+magicmoves_r_offsets[38], magicmovesrshared.refs+magicmoves_r_offsets[39],
+	magicmovesrshared.refs+magicmoves_r_offsets[40], magicmovesrshared.refs+magicmoves_r_offsets[41], magicmovesrshared.refs+magicmoves_r_offsets[42], magicmovesrshared.refs+magicmoves_r_offsets[43],
+	magicmovesrshared.refs+magicmoves_r_offsets[44], magicmovesrshared.refs+magicmoves_r_offsets[45], magicmovesrshared.refs+magicmoves_r_offsets[46], magicmovesrshared.refs+magicmoves_r_offsets[47],
+	magicmovesrshared.refs+magicmoves_r_offsets[48], magicmovesrshared.refs+magicmoves_r_offsets[49], magicmovesrshared.refs+magicmoves_r_offsets[50], magicmovesrshared.refs+magicmoves_r_offsets[51],
+	magicmovesrshared.refs+magicmoves_r_offsets[52], magicmovesrshared.refs+magicmoves_r_offsets[53], magicmovesrshared.refs+magicmoves_r_offsets[54], magicmovesrshared.refs+magicmoves_r_offsets[55],
+	magicmovesrshared.refs+magicmoves_r_offsets[56], magicmovesrshared.refs+magicmoves_r_offsets[57], magicmovesrshared.refs+magicmoves_r_offsets[58], magicmovesrshared.refs+magicmoves_r_offsets[59],
+	magicmovesrshared.refs+magicmoves_r_offsets[60], magicmovesrshared.refs+magicmoves_r_offsets[61], magicmovesrshared.refs+magicmoves_r_offsets[62], magicmovesrshared.refs+magicmoves_r_offsets[63]
+};
+const U64* const magicmoves_r_shared_sets[64]=
+{
+	magicmovesrshared.sets+magicmovesrshared.setoffsets[0], magicmovesrshared.sets+magicmovesrshared.setoffsets[1], magicmovesrshared.sets+magicmovesrshared.setoffsets[2], magicmovesrshared.sets+magicmovesrshared.setoffsets[3],
+	magicmovesrshared.sets+magicmovesrshared.setoffsets[4], magicmovesrshared.sets+magicmovesrshared.setoffsets[5], magicmovesrshared.sets+magicmovesrshared.setoffsets[6], magicmovesrshared.sets+magicmovesrshared.setoffsets[7],
+	magicmovesrshared.sets+magicmovesrshared.setoffsets[8], magicmovesrshared.sets+magicmovesrshared.setoffsets[9], magicmovesrshared.sets+magicmovesrshared.setoffsets[10], magicmovesrshared.sets+magicmovesrshared.setoffsets[11],
+	magicmovesrshared.sets+magicmovesrshared.setoffsets[12], magicmovesrshared.sets+magicmovesrshared.setoffsets[13], magicmovesrshared.sets+magicmovesrshared.setoffsets[14], magicmovesrshared.sets+magicmovesrshared.setoffsets[15],
+	magicmovesrshared.sets+magicmovesrshared.setoffsets[16], magicmovesrshared.sets+magicmovesrshared.setoffsets[17], magicmovesrshared.sets+magicmovesrshared.setoffsets[18], magicmovesrshared.sets+magicmovesrshared.setoffsets[19],
+	magicmovesrshared.sets+magicmovesrshared.setoffsets[20], magicmovesrshared.sets+magicmovesrshared.setoffsets[21], magicmovesrshared.sets+magicmovesrshared.setoffsets[22], magicmovesrshared.sets+magicmovesrshared.setoffsets[23],
+	magicmovesrshared.sets+magicmovesrshared.setoffsets[24], magicmovesrshared.sets+magicmovesrshared.setoffsets[25], magicmovesrshared.sets+magicmovesrshared.setoffsets[26], magicmovesrshared.sets+magicmovesrshared.setoffsets[27],
+	magicmovesrshared.sets+magicmovesrshared.setoffsets[28], magicmovesrshared.sets+magicmovesrshared.setoffsets[29], magicmovesrshared.sets+magicmovesrshared.setoffsets[30], magicmovesrshared.sets+magicmovesrshared.setoffsets[31],
+	magicmovesrshared.sets+magicmovesrshared.setoffsets[32], magicmovesrshared.sets+magicmovesrshared.setoffsets[33], magicmovesrshared.sets+magicmovesrshared.setoffsets[34], magicmovesrshared.sets+magicmovesrshared.setoffsets[35],
+	magicmovesrshared.sets+magicmovesrshared.setoffsets[36], magicmovesrshared.sets+magicmovesrshared.setoffsets[37], magicmovesrshared.sets+magicmovesrshared.setoffsets[38], magicmovesrshared.sets+magicmovesrshared.setoffsets[39],
+	magicmovesrshared.sets+magicmovesrshared.setoffsets[40], magicmovesrshared.sets+magicmovesrshared.setoffsets[41], magicmovesrshared.sets+magicmovesrshared.setoffsets[42], magicmovesrshared.sets+magicmovesrshared.setoffsets[43],
+	magicmovesrshared.sets+magicmovesrshared.setoffsets[44], magicmovesrshared.sets+magicmovesrshared.setoffsets[45], magicmovesrshared.sets+magicmovesrshared.setoffsets[46], magicmovesrshared.sets+magicmovesrshared.setoffsets[47],
+	magicmovesrshared.sets+magicmovesrshared.setoffsets[48], magicmovesrshared.sets+magicmovesrshared.setoffsets[49], magicmovesrshared.sets+magicmovesrshared.setoffsets[50], magicmovesrshared.sets+magicmovesrshared.setoffsets[51],
+	magicmovesrshared.sets+magicmovesrshared.setoffsets[52], magicmovesrshared.sets+magicmovesrshared.setoffsets[53], magicmovesrshared.sets+magicmovesrshared.setoffsets[54], magicmovesrshared.sets+magicmovesrshared.setoffsets[55],
+	magicmovesrshared.sets+magicmovesrshared.setoffsets[56], magicmovesrshared.sets+magicmovesrshared.setoffsets[57], magicmovesrshared.sets+magicmovesrshared.setoffsets[58], magicmovesrshared.sets+magicmovesrshared.setoffsets[59],
+	magicmovesrshared.sets+magicmovesrshared.setoffsets[60], magicmovesrshared.sets+magicmovesrshared.setoffsets[61], magicmovesrshared.sets+magicmovesrshared.setoffsets[62], magicmovesrshared.sets+magicmovesrshared.setoffsets[63]
+};
+#endif //MINIMIZE_MAGIC
+
 //used so that the original indices can be left as const so that the compiler can optimize better
 
 #ifndef PERFECT_MAGIC_HASH
-	#ifdef MINIMIZE_MAGIC
-		#define BmagicNOMASK2(square, occupancy) *(magicmoves_b_indices2[square]+(((occupancy)*magicmoves_b_magics[square])>>magicmoves_b_shift[square]))
-		#define RmagicNOMASK2(square, occupancy) *(magicmoves_r_indices2[square]+(((occupancy)*magicmoves_r_magics[square])>>magicmoves_r_shift[square]))
-	#else
+	#ifndef MINIMIZE_MAGIC
 		#define BmagicNOMASK2(square, occupancy) magicmovesbdb[square][((occupancy)*magicmoves_b_magics[square])>>MINIMAL_B_BITS_SHIFT(square)]
 		#define RmagicNOMASK2(square, occupancy) magicmovesrdb[square][((occupancy)*magicmoves_r_magics[square])>>MINIMAL_R_BITS_SHIFT(square)]
 	#endif
@@ -321,6 +503,12 @@ U64 initmagicmoves_Bmoves(const int square, const U64 occ)
 */
 #endif
 
+#ifdef MINIMIZE_MAGIC
+//the minimized databases are built at compile time
+void initmagicmoves(void)
+{
+}
+#else
 void initmagicmoves(void)
 {
 	int i;
@@ -337,48 +525,6 @@ void initmagicmoves(void)
 	56, 45, 25, 31, 35, 16,  9, 12,
 	44, 24, 15,  8, 23,  7,  6,  5};
 
-#ifdef MINIMIZE_MAGIC
-	//identical to magicmove_x_indices except without the const modifer
-	U64* magicmoves_b_indices2[64]=
-	{
-		magicmovesbdb+4992, magicmovesbdb+2624,  magicmovesbdb+256,  magicmovesbdb+896,
-		magicmovesbdb+1280, magicmovesbdb+1664, magicmovesbdb+4800, magicmovesbdb+5120,
-		magicmovesbdb+2560, magicmovesbdb+2656,  magicmovesbdb+288,  magicmovesbdb+928,
-		magicmovesbdb+1312, magicmovesbdb+1696, magicmovesbdb+4832, magicmovesbdb+4928,
-		magicmovesbdb+0,     magicmovesbdb+128,  magicmovesbdb+320,  magicmovesbdb+960,
-		magicmovesbdb+1344, magicmovesbdb+1728, magicmovesbdb+2304, magicmovesbdb+2432,
-		magicmovesbdb+32,    magicmovesbdb+160,  magicmovesbdb+448, magicmovesbdb+2752,
-		magicmovesbdb+3776, magicmovesbdb+1856, magicmovesbdb+2336, magicmovesbdb+2464,
-		magicmovesbdb+64,    magicmovesbdb+192,  magicmovesbdb+576, magicmovesbdb+3264,
-		magicmovesbdb+4288, magicmovesbdb+1984, magicmovesbdb+2368, magicmovesbdb+2496,
-		magicmovesbdb+96,    magicmovesbdb+224,  magicmovesbdb+704, magicmovesbdb+1088,
-		magicmovesbdb+1472, magicmovesbdb+2112, magicmovesbdb+2400, magicmovesbdb+2528,
-		magicmovesbdb+2592, magicmovesbdb+2688,  magicmovesbdb+832, magicmovesbdb+1216,
-		magicmovesbdb+1600, magicmovesbdb+2240, magicmovesbdb+4864, magicmovesbdb+4960,
-		magicmovesbdb+5056, magicmovesbdb+2720,  magicmovesbdb+864, magicmovesbdb+1248,
-		magicmovesbdb+1632, magicmovesbdb+2272, magicmovesbdb+4896, magicmovesbdb+5184
-	};
-	U64* magicmoves_r_indices2[64]=
-	{
-		magicmovesrdb+86016, magicmovesrdb+73728, magicmovesrdb+36864, magicmovesrdb+43008,
-		magicmovesrdb+47104, magicmovesrdb+51200, magicmovesrdb+77824, magicmovesrdb+94208,
-		magicmovesrdb+69632, magicmovesrdb+32768, magicmovesrdb+38912, magicmovesrdb+10240,
-		magicmovesrdb+14336, magicmovesrdb+53248, magicmovesrdb+57344, magicmovesrdb+81920,
-		magicmovesrdb+24576, magicmovesrdb+33792,  magicmovesrdb+6144, magicmovesrdb+11264,
-		magicmovesrdb+15360, magicmovesrdb+18432, magicmovesrdb+58368, magicmovesrdb+61440,
-		magicmovesrdb+26624,  magicmovesrdb+4096,  magicmovesrdb+7168,     magicmovesrdb+0,
-		magicmovesrdb+2048,  magicmovesrdb+19456, magicmovesrdb+22528, magicmovesrdb+63488,
-		magicmovesrdb+28672,  magicmovesrdb+5120,  magicmovesrdb+8192,  magicmovesrdb+1024,
-		magicmovesrdb+3072,  magicmovesrdb+20480, magicmovesrdb+23552, magicmovesrdb+65536,
-		magicmovesrdb+30720, magicmovesrdb+34816,  magicmovesrdb+9216, magicmovesrdb+12288,
-		magicmovesrdb+16384, magicmovesrdb+21504, magicmovesrdb+59392, magicmovesrdb+67584,
-		magicmovesrdb+71680, magicmovesrdb+35840, magicmovesrdb+39936, magicmovesrdb+13312,
-		magicmovesrdb+17408, magicmovesrdb+54272, magicmovesrdb+60416, magicmovesrdb+83968,
-		magicmovesrdb+90112, magicmovesrdb+75776, magicmovesrdb+40960, magicmovesrdb+45056,
-		magicmovesrdb+49152, magicmovesrdb+55296, magicmovesrdb+79872, magicmovesrdb+98304
-	};
-#endif // MINIMIZE_MAGIC
-
 
 #ifdef PERFECT_MAGIC_HASH
 	for(i=0;i<1428;i++)
@@ -462,6 +608,7 @@ void initmagicmoves(void)
 		}
 	}
 }
+#endif //MINIMIZE_MAGIC
 
 void initMagics()
 {
@@ -0,0 +1,149 @@
+#include "movepicker.hpp"
+#include "movegen.hpp"
+
+// Added to the score of a capture that loses material, which sorts it below
+// every other capture
+const int LOSING_CAPTURE = -100000;
+
+// Constructs a picker for the board with the given table move and killers,
+// both of which are checked before they are handed out
+MovePicker::MovePicker(Board& b, Move ttMove, const Move* killers) : b(b) {
+    this->ttMove = ttMove;
+    this->killers[0] = killers[0];
+    this->killers[1] = killers[1];
+    if (this->killers[1] == this->killers[0]) {
+        this->killers[1] = Move();
+    }
+    stage = STAGE_TT;
+    moveStage = STAGE_TT;
+    captureIndex = 0;
+    killerIndex = 0;
+    quietIndex = 0;
+    generated = 0;
+}
+
+
+// Moves the best scored move at or after the index to the index, and returns it
+ScoredMove& MovePicker::pickBest(MoveList& moveList, int index) {
+    int best = index;
+    for (int i = index + 1; i < moveList.size(); i++) {
+        if (moveList[i].score > moveList[best].score) {
+            best = i;
+        }
+    }
+    std::swap(moveList[index], moveList[best]);
+    return moveList[index];
+}
+
+
+// Returns whether the move is the table move or a killer, which are handed out
+// before the generated moves
+bool MovePicker::isSpecial(Move m) {
+    return m == ttMove || m == killers[0] || m == killers[1];
+}
+
+
+// Returns the next legal move, or the null move once there are none left
+Move MovePicker::next() {
+    Color other = (b.getToMove() == nWhite ? nBlack : nWhite);
+
+    switch (stage) {
+        case STAGE_TT:
+            stage++;
+            if (ttMove != Move() && b.isPseudoLegal(ttMove) && b.isLegal(ttMove)) {
+                moveStage = STAGE_TT;
+                return ttMove;
+            }
+            ttMove = Move();
+            [[fallthrough]];
+
+        case STAGE_GEN_CAPTURES:
+            b.getToMove() == nWhite ? getCaptures<nWhite>(captures, b) :
+                getCaptures<nBlack>(captures, b);
+            generated += captures.size();
+            for (ScoredMove& sm : captures) {
+                Move m = sm.move;
+                Piece victim = (m.getFlags() == 5 ? nPawn : b.getPiece(m.getTo()));
+                Piece attacker = b.getPiece(m.getFrom());
+                sm.score = PieceVals[victim] - attacker;
+                if (PieceVals[victim] < PieceVals[attacker] &&
+                        b.attacked(m.getTo(), other)) {
+                    sm.score += LOSING_CAPTURE;
+                }
+            }
+            stage++;
+            [[fallthrough]];
+
+        case STAGE_GOOD_CAPTURES:
+            while (captureIndex < captures.size()) {
+                ScoredMove& sm = pickBest(captures, captureIndex);
+                if (sm.score < 0) {
+                    break;
+                }
+                captureIndex++;
+                if (sm.move != ttMove) {
+                    moveStage = STAGE_GOOD_CAPTURES;
+                    return sm.move;
+                }
+            }
+            stage++;
+            [[fallthrough]];
+
+        case STAGE_KILLERS:
+            while (killerIndex < 2) {
+                Move& m = killers[killerIndex++];
+                if (m != ttMove && !m.isCapture() && b.isPseudoLegal(m) &&
+                        b.isLegal(m)) {
+                    moveStage = STAGE_KILLERS;
+                    return m;
+                }
+                m = Move();
+            }
+            stage++;
+            [[fallthrough]];
+
+        case STAGE_GEN_QUIETS:
+            b.getToMove() == nWhite ? getMoves<nWhite, QUIET>(quiets, b) :
+                getMoves<nBlack, QUIET>(quiets, b);
+            generated += quiets.size();
+            stage++;
+            [[fallthrough]];
+
+        case STAGE_QUIETS:
+            while (quietIndex < quiets.size()) {
+                Move m = quiets[quietIndex++].move;
+                if (!isSpecial(m)) {
+                    moveStage = STAGE_QUIETS;
+                    return m;
+                }
+            }
+            stage++;
+            [[fallthrough]];
+
+        case STAGE_BAD_CAPTURES:
+            while (captureIndex < captures.size()) {
+                ScoredMove& sm = pickBest(captures, captureIndex++);
+                if (sm.move != ttMove) {
+                    moveStage = STAGE_BAD_CAPTURES;
+                    return sm.move;
+                }
+            }
+            stage++;
+            [[fallthrough]];
+
+        default:
+            return Move();
+    }
+}
+
+
+// Returns the stage of the move last handed out
+int MovePicker::getStage() const {
+    return moveStage;
+}
+
+
+// Returns the number of moves generated so far
+int MovePicker::getGenerated() const {
+    return generated;
+}
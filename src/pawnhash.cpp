@@ -0,0 +1,33 @@
+#include "pawnhash.hpp"
+#include <algorithm>
+
+// Constructs an empty table
+PawnTable::PawnTable() : entries(PAWN_TABLE_SIZE) {
+    probes = 0;
+    hits = 0;
+}
+
+
+// Returns the number of probes since the statistics were reset
+unsigned long long PawnTable::getProbes() const {
+    return probes;
+}
+
+
+// Returns the number of those probes that found their key
+unsigned long long PawnTable::getHits() const {
+    return hits;
+}
+
+
+// Sets the probe and hit counts back to zero
+void PawnTable::resetStats() {
+    probes = 0;
+    hits = 0;
+}
+
+
+// Empties every entry of the table
+void PawnTable::clear() {
+    std::fill(entries.begin(), entries.end(), PawnEntry());
+}
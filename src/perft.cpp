@@ -0,0 +1,226 @@
+#include "perft.hpp"
+#include "movegen.hpp"
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Constructs a table of the given size in MB, rounded down to a power of two.
+// A size of 0 gives a table that never holds anything.
+PerftTable::PerftTable(int mb) {
+    size_t entries = (size_t)mb * 1024 * 1024 / sizeof(PerftEntry);
+    size_t size = 1;
+    while (size * 2 <= entries) {
+        size *= 2;
+    }
+    table.resize(entries == 0 ? 0 : size, PerftEntry{0, 0});
+    mask = (table.empty() ? 0 : table.size() - 1);
+}
+
+
+// Returns whether the table holds the count for the position and depth,
+// storing it in count if so
+bool PerftTable::probe(unsigned long long key, int depth, unsigned long long&
+        count) const {
+    if (table.empty()) {
+        return false;
+    }
+    const PerftEntry& entry = table[key & mask];
+    unsigned long long data = entry.data;
+    if ((entry.check ^ data) != key || (int)(data & 0xff) != depth) {
+        return false;
+    }
+    count = data >> 8;
+    return true;
+}
+
+
+// Stores the count for the position and depth
+void PerftTable::store(unsigned long long key, int depth, unsigned long long
+        count) {
+    if (table.empty()) {
+        return;
+    }
+    PerftEntry& entry = table[key & mask];
+    unsigned long long data = (count << 8) | depth;
+    entry.check = key ^ data;
+    entry.data = data;
+}
+
+
+// Returns the number of leaf positions the given depth below the board. The
+// moves at the last ply are counted without being made. The table is used when
+// one is given.
+unsigned long long perft(Board& b, int depth, PerftTable* table) {
+    if (depth == 0) {
+        return 1;
+    }
+
+    // the last ply isn't worth a table lookup
+    unsigned long long count = 0;
+    if (depth > 1 && table && table->probe(b.getZobrist(), depth, count)) {
+        return count;
+    }
+
+    MoveList moveList;
+    b.getToMove() == nWhite ? getLegalMoves<nWhite>(moveList, b) :
+        getLegalMoves<nBlack>(moveList, b);
+    if (depth == 1) {
+        return moveList.size();
+    }
+
+    for (ScoredMove& sm : moveList) {
+        b.makeMove(sm.move);
+        count += perft(b, depth - 1, table);
+        b.unmakeMove(sm.move);
+    }
+
+    if (table) {
+        table->store(b.getZobrist(), depth, count);
+    }
+    return count;
+}
+
+
+// Holds a subtree for a perft thread to walk, which is reached by a root move
+// and a reply
+struct PerftTask {
+    int root;
+    Move moves[2];
+};
+
+// Holds the tasks dealt to one perft thread. Its thread takes them from the
+// back, and the other threads steal them from the front.
+struct PerftQueue {
+    std::mutex lock;
+    std::deque<PerftTask> tasks;
+};
+
+
+// Takes a task from the thread's own queue, or else steals one from another
+// thread. Returns false once every queue is empty.
+static bool takeTask(std::vector<PerftQueue>& queues, int id, PerftTask& task) {
+    int threads = queues.size();
+    {
+        std::lock_guard<std::mutex> guard(queues[id].lock);
+        if (!queues[id].tasks.empty()) {
+            task = queues[id].tasks.back();
+            queues[id].tasks.pop_back();
+            return true;
+        }
+    }
+    for (int i = 1; i < threads; i++) {
+        PerftQueue& victim = queues[(id + i) % threads];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// Returns the number of leaf positions the given depth below the board, counted
+// on the given number of threads, and adds the count below each root move to
+// rootCounts, which is indexed like the legal moves of the board. The subtrees
+// two plies down are dealt out to the threads, each of which walks them on its
+// own copy of the board and takes work from the others once its own runs out.
+// The table, if given, is shared by all the threads.
+unsigned long long parallelPerft(const Board& b, int depth, int threads,
+        PerftTable* table, std::vector<unsigned long long>& rootCounts) {
+    Board root = b;
+    MoveList moveList;
+    root.getToMove() == nWhite ? getLegalMoves<nWhite>(moveList, root) :
+        getLegalMoves<nBlack>(moveList, root);
+    rootCounts.resize(moveList.size(), 0);
+
+    // shallow trees aren't worth splitting
+    if (depth < 3 || threads <= 1) {
+        unsigned long long nodes = 0;
+        for (int i = 0; i < moveList.size(); i++) {
+            root.makeMove(moveList[i].move);
+            unsigned long long count = perft(root, depth - 1, table);
+            root.unmakeMove(moveList[i].move);
+            rootCounts[i] += count;
+            nodes += count;
+        }
+        return nodes;
+    }
+
+    // deal out the subtrees below each reply to the root moves in turn
+    std::vector<PerftQueue> queues(threads);
+    int next = 0;
+    for (int i = 0; i < moveList.size(); i++) {
+        root.makeMove(moveList[i].move);
+        MoveList replies;
+        root.getToMove() == nWhite ? getLegalMoves<nWhite>(replies, root) :
+            getLegalMoves<nBlack>(replies, root);
+        for (ScoredMove& reply : replies) {
+            queues[next].tasks.push_back(PerftTask{i, {moveList[i].move,
+                    reply.move}});
+            next = (next + 1) % threads;
+        }
+        root.unmakeMove(moveList[i].move);
+    }
+
+    // each thread counts into its own totals, which are added up at the end
+    std::vector<std::vector<unsigned long long>> counts(threads,
+            std::vector<unsigned long long>(moveList.size(), 0));
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            std::unique_ptr<Board> board = std::make_unique<Board>(root);
+            PerftTask task;
+            while (takeTask(queues, t, task)) {
+                board->makeMove(task.moves[0]);
+                board->makeMove(task.moves[1]);
+                counts[t][task.root] += perft(*board, depth - 2, table);
+                board->unmakeMove(task.moves[1]);
+                board->unmakeMove(task.moves[0]);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    unsigned long long nodes = 0;
+    for (int t = 0; t < threads; t++) {
+        for (int i = 0; i < moveList.size(); i++) {
+            rootCounts[i] += counts[t][i];
+            nodes += counts[t][i];
+        }
+    }
+    return nodes;
+}
+
+
+// Runs perft from the board on the given number of threads, printing the count
+// below each root move, the total and the speed. Uses a perft table of the
+// given size in MB, if not 0.
+unsigned long long perftDivide(Board& b, int depth, int hashMB, int threads) {
+    PerftTable table(hashMB);
+    std::vector<unsigned long long> rootCounts;
+    auto start = std::chrono::high_resolution_clock::now();
+
+    unsigned long long nodes = parallelPerft(b, depth, threads, hashMB > 0 ?
+            &table : nullptr, rootCounts);
+
+    auto dur = std::chrono::high_resolution_clock::now() - start;
+    long ms = std::chrono::duration_cast<std::chrono::milliseconds>(dur).count();
+
+    MoveList moveList;
+    b.getToMove() == nWhite ? getLegalMoves<nWhite>(moveList, b) :
+        getLegalMoves<nBlack>(moveList, b);
+    for (int i = 0; i < moveList.size(); i++) {
+        std::cout << moveList[i].move.toStr() << ": " << rootCounts[i] <<
+            std::endl;
+    }
+    std::cout << std::endl << "info string perft depth " << depth << " nodes " <<
+        nodes << " time " << ms << " nps " << (unsigned long long)(0.5 + nodes *
+                1000.0 / std::max(ms, 1L)) << std::endl;
+    return nodes;
+}
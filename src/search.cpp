@@ -2,9 +2,40 @@
 
 const int MATE_VALUE = 25000;
 const int MAX_VALUE = 50000;
+int lazyMargin = LAZY_MARGIN_DEFAULT;
 
-Search::Search(SearchInfo* info) {
+Search::Search(SearchInfo* info, PawnTable* pawnTable) {
     this->info = info;
+    this->pawnTable = pawnTable;
+}
+
+
+// Constructs a helper thread searching a copy of the given board with the same
+// limits as the main search, evaluating pawns with the given table
+SearchThread::SearchThread(const Board& b, const SearchInfo& main, PawnTable*
+        pawnTable) : board(b), search(&info, pawnTable) {
+    info.startTime = main.startTime;
+    info.duration = main.duration;
+    info.infinite = main.infinite;
+    info.stopped = false;
+    completedDepth = 0;
+    score = 0;
+}
+
+
+// Runs iterative deepening up to the given depth until stopped. Odd helpers
+// start one ply deeper so the threads spread out over different depths.
+void SearchThread::run(int max, int id) {
+    for (int depth = 1 + (id & 1); depth <= max; depth++) {
+        info.depth = depth;
+        int value = search.negamaxRoot(board, depth, -MAX_VALUE, MAX_VALUE);
+        if (info.stopped) {
+            break;
+        }
+        completedDepth = depth;
+        score = value;
+        bestMove = search.bestMove;
+    }
 }
 
 // Alpha beta search algorithm. Takes a board and a search depth, and finds the board score
@@ -19,21 +50,17 @@ int Search::negamax(Board &b, int depth, int alpha, int beta, bool pv, bool
 
     int ply = info->depth - depth;
 
-    int hashKey = b.getZobrist() % TABLE_SIZE;
-    HashEntry oldEntry = b.getTransTable(hashKey);
-    HashEntry entry = b.getTransTable(hashKey);
+    HashEntry entry = TT.probe(b.getZobrist());
 
     if (entry.nodeType != HASH_NULL && entry.depth >= depth) { // valid node
-        if (entry.zobrist == b.getZobrist()) {
-            if (entry.nodeType == HASH_EXACT) {
-                return entry.score;
-            } else if (entry.zobrist == HASH_ALPHA) {
-                alpha = max(alpha, entry.score);
-            } else {
-                beta = max(beta, entry.score);
-            }
+        if (entry.nodeType == HASH_EXACT) {
+            return entry.score;
+        } else if (entry.nodeType == HASH_ALPHA) {
+            alpha = max(alpha, entry.score);
+        } else {
+            beta = min(beta, entry.score);
         }
-        if (alpha > beta) {
+        if (alpha >= beta) {
             return entry.score;
         }
     }
@@ -45,20 +72,6 @@ int Search::negamax(Board &b, int depth, int alpha, int beta, bool pv, bool
         return score;
     }
 
-    std::vector<Move> moves;
-    std::vector<MoveData> moveList;
-    b.getToMove() == nWhite ? getLegalMoves<nWhite>(moves, b) : getLegalMoves<nBlack>(moves, b);
-
-    if (moves.empty()) { 
-        if (b.inCheck()) {
-            return -MATE_VALUE - depth;
-       } else {
-            return 0;
-       }
-    }
-
-    Search::orderMoves(b, moves, moveList, ply);
-
     Move currBest;
 
     unsigned int loc = 0;
@@ -75,65 +88,69 @@ int Search::negamax(Board &b, int depth, int alpha, int beta, bool pv, bool
         }
     }
 
-    for (MoveData mv : moveList) {
+    // moves are generated in stages as they are needed, so the first moves can
+    // cut off before the rest are generated
+    MovePicker picker(b, entry.move, killerMoves[ply]);
+    for (Move m = picker.next(); m != Move(); m = picker.next()) {
         loc++;
-        if (2 * loc > moveList.size() && info->stopped) {
-            return alpha;
+        if (loc > 1 && info->stopped) {
+            break;
         }
         int searchVal;
 
-        Move m = mv.move;
-        if (b.isLegal(m)) {
-            b.makeMove(m);
-            if (loc > 1) {
-                if (loc >= 4 && depth >= 3 && !m.isCapture() &&
-                        !b.inCheck()) {
-                    searchVal = -negamax(b, depth - 2, -alpha - 1, -alpha,
-                            false, true);
-                } else {
-                    searchVal = -negamax(b, depth - 1, -alpha - 1, -alpha,
-                            false, true);
-                }
-                if (alpha < searchVal && searchVal < beta) {
-                    searchVal = -negamax(b, depth - 1, -beta, -searchVal, false, true);
-                }
+        b.makeMove(m);
+        if (loc > 1) {
+            if (loc >= 4 && depth >= 3 && !m.isCapture() &&
+                    !b.inCheck()) {
+                searchVal = -negamax(b, depth - 2, -alpha - 1, -alpha,
+                        false, true);
             } else {
-                searchVal = -negamax(b, depth - 1, -beta, -alpha, true, true);
+                searchVal = -negamax(b, depth - 1, -alpha - 1, -alpha,
+                        false, true);
             }
-            b.unmakeMove(m);
-            if (searchVal > alpha) {
-                currBest = m;
+            if (alpha < searchVal && searchVal < beta) {
+                searchVal = -negamax(b, depth - 1, -beta, -searchVal, false, true);
             }
-            alpha = max(searchVal, alpha);
+        } else {
+            searchVal = -negamax(b, depth - 1, -beta, -alpha, true, true);
+        }
+        b.unmakeMove(m);
+        if (searchVal > alpha) {
+            currBest = m;
+        }
+        alpha = max(searchVal, alpha);
 
-            if (alpha >= beta) {
-                b.killerMoves[ply][1] = b.killerMoves[ply][0];
-                b.killerMoves[ply][0] = m;
-                break;
+        if (alpha >= beta) {
+            info->cutoffs[picker.getStage()]++;
+            if (!m.isCapture() && m != killerMoves[ply][0]) {
+                killerMoves[ply][1] = killerMoves[ply][0];
+                killerMoves[ply][0] = m;
             }
+            break;
         }
     }
+    info->generated += picker.getGenerated();
 
-    entry.score = alpha;
-    entry.depth = depth;
-    entry.move = currBest;
+    if (loc == 0) {
+        if (b.inCheck()) {
+            return -MATE_VALUE - depth;
+        } else {
+            return 0;
+        }
+    }
+    if (info->stopped) {
+        return alpha;
+    }
 
+    HashType nodeType;
     if (alpha <= oldAlpha) {
-        entry.nodeType = HASH_BETA;
+        nodeType = HASH_BETA;
     } else if (alpha >= beta) {
-        entry.nodeType = HASH_ALPHA;
+        nodeType = HASH_ALPHA;
     } else {
-        entry.nodeType = HASH_EXACT;
-    }
-
-    if (oldEntry.nodeType != HASH_EXACT && entry.nodeType == HASH_EXACT) {
-        b.setTransTable(hashKey, entry);
-    }
-    if (!(oldEntry.nodeType == HASH_EXACT && entry.nodeType != HASH_EXACT)) {
-        if (entry.depth >= oldEntry.depth) {
-            b.setTransTable(hashKey, entry);
-        }
+        nodeType = HASH_EXACT;
     }
+    TT.store(b.getZobrist(), depth, alpha, EVAL_NONE, nodeType, currBest);
 
     return alpha;
 }
@@ -146,22 +163,18 @@ int Search::negamaxRoot(Board &b, int depth, int alpha, int beta) {
     info->nodes++;
     int ply = info->depth - depth;
 
-    int hashKey = b.getZobrist() % TABLE_SIZE;
-    HashEntry oldEntry = b.getTransTable(hashKey);
-    HashEntry entry = b.getTransTable(hashKey);
+    HashEntry entry = TT.probe(b.getZobrist());
 
     if (entry.nodeType != HASH_NULL && entry.depth >= depth) { // valid node
-        if (entry.zobrist == b.getZobrist()) {
-            if (entry.nodeType == HASH_EXACT) {
-                bestMove = entry.move;
-                return entry.score;
-            } else if (entry.zobrist == HASH_ALPHA) {
-                alpha = max(alpha, entry.score);
-            } else {
-                beta = max(beta, entry.score);
-            }
+        if (entry.nodeType == HASH_EXACT) {
+            bestMove = entry.move;
+            return entry.score;
+        } else if (entry.nodeType == HASH_ALPHA) {
+            alpha = max(alpha, entry.score);
+        } else {
+            beta = min(beta, entry.score);
         }
-        if (alpha > beta) {
+        if (alpha >= beta) {
             bestMove = entry.move;
             return entry.score;
         }
@@ -174,19 +187,18 @@ int Search::negamaxRoot(Board &b, int depth, int alpha, int beta) {
         return score;
     }
 
-    std::vector<Move> moves;
-    std::vector<MoveData> moveList;
-    b.getToMove() == nWhite ? getLegalMoves<nWhite>(moves, b) : getLegalMoves<nBlack>(moves, b);
+    MoveList moveList;
+    b.getToMove() == nWhite ? getLegalMoves<nWhite>(moveList, b) : getLegalMoves<nBlack>(moveList, b);
 
-    Search::orderMoves(b, moves, moveList, ply);
+    Search::orderMoves(b, moveList, ply);
 
     unsigned int loc = 0;
 
-    for (MoveData mv : moveList) {
+    for (const ScoredMove& mv : moveList) {
         loc++;
         auto time = chrono::high_resolution_clock::now();
         auto dur = time - info->startTime;
-        if (2 * loc > moveList.size() && ((info->duration != 0 && 
+        if (2 * loc > (unsigned int)moveList.size() && ((info->duration != 0 && 
                 info->duration <=
                 chrono::duration_cast<std::chrono::milliseconds>(dur).count())
                 || info->stopped)) {
@@ -196,51 +208,40 @@ int Search::negamaxRoot(Board &b, int depth, int alpha, int beta) {
 
         Move m = mv.move;
         int searchVal;
-        if (b.isLegal(m)) {
-            b.makeMove(m);
-            if (loc > 1) {
-                searchVal = -negamax(b, depth - 1, -alpha - 1, -alpha, false,
-                        true);
-                if (alpha < searchVal && searchVal < beta) {
-                    searchVal = -negamax(b, depth - 1, -beta, -searchVal, false, true);
-                }
-            } else {
-                searchVal = -negamax(b, depth - 1, -beta, -alpha, true, true);
-            }
-            b.unmakeMove(m);
-            if (searchVal > alpha) {
-                bestMove = m;
+        b.makeMove(m);
+        if (loc > 1) {
+            searchVal = -negamax(b, depth - 1, -alpha - 1, -alpha, false,
+                    true);
+            if (alpha < searchVal && searchVal < beta) {
+                searchVal = -negamax(b, depth - 1, -beta, -searchVal, false, true);
             }
-            alpha = max(searchVal, alpha);
+        } else {
+            searchVal = -negamax(b, depth - 1, -beta, -alpha, true, true);
+        }
+        b.unmakeMove(m);
+        if (searchVal > alpha) {
+            bestMove = m;
+        }
+        alpha = max(searchVal, alpha);
 
-            if (alpha >= beta) {
-                b.killerMoves[ply][1] = b.killerMoves[ply][0];
-                b.killerMoves[ply][0] = m;
-                break;
+        if (alpha >= beta) {
+            if (!m.isCapture() && m != killerMoves[ply][0]) {
+                killerMoves[ply][1] = killerMoves[ply][0];
+                killerMoves[ply][0] = m;
             }
+            break;
         }
     }
 
-    entry.score = alpha;
-    entry.depth = depth;
-    entry.move = bestMove;
-
+    HashType nodeType;
     if (alpha <= oldAlpha) {
-        entry.nodeType = HASH_BETA;
+        nodeType = HASH_BETA;
     } else if (alpha >= beta) {
-        entry.nodeType = HASH_ALPHA;
+        nodeType = HASH_ALPHA;
     } else {
-        entry.nodeType = HASH_EXACT;
-    }
-
-    if (oldEntry.nodeType != HASH_EXACT && entry.nodeType == HASH_EXACT) {
-        b.setTransTable(hashKey, entry);
-    }
-    if (!(oldEntry.nodeType == HASH_EXACT && entry.nodeType != HASH_EXACT)) {
-        if (entry.depth >= oldEntry.depth) {
-            b.setTransTable(hashKey, entry);
-        }
+        nodeType = HASH_EXACT;
     }
+    TT.store(b.getZobrist(), depth, alpha, EVAL_NONE, nodeType, bestMove);
 
     return alpha;
 }
@@ -248,7 +249,22 @@ int Search::negamaxRoot(Board &b, int depth, int alpha, int beta) {
 
 // Performs quiescence search on the given board
 int Search::quiesce(Board &b, int alpha, int beta) {
-    int stand_pat = b.boardScore();
+    // the terms beyond material rarely swing the score by more than the
+    // margin, so when the material score is that far outside the window the
+    // full evaluation would not change the result
+    int stand_pat = b.materialScore();
+    info->qEvals++;
+    if (stand_pat - lazyMargin >= beta || stand_pat + lazyMargin <= alpha) {
+        info->lazyEvals++;
+    } else {
+        info->cacheProbes++;
+        if (evalCache.probe(b.getZobrist(), stand_pat)) {
+            info->cacheHits++;
+        } else {
+            stand_pat = b.boardScore(*pawnTable);
+            evalCache.store(b.getZobrist(), stand_pat);
+        }
+    }
     info->nodes++;
     if (stand_pat >= beta) {
         return beta;
@@ -256,51 +272,47 @@ int Search::quiesce(Board &b, int alpha, int beta) {
     if (alpha < stand_pat) {
         alpha = stand_pat;
     }
-    vector<Move> moves;
-    vector<MoveData> moveList;
+    MoveList moveList;
 
-    b.getToMove() == nWhite ? getCaptures<nWhite>(moves, b) : getCaptures<nBlack>(moves, b);
-    Search::orderMoves(b, moves, moveList, -1);
-    for (MoveData md : moveList)  {
+    b.getToMove() == nWhite ? getCaptures<nWhite>(moveList, b) : getCaptures<nBlack>(moveList, b);
+    Search::orderMoves(b, moveList, -1);
+    for (const ScoredMove& md : moveList)  {
         Move m = md.move;
-        if (b.isLegal(m)) {
-            b.makeMove(m);
-            int score = -quiesce(b, -beta, -alpha);
-            b.unmakeMove(m);
+        b.makeMove(m);
+        int score = -quiesce(b, -beta, -alpha);
+        b.unmakeMove(m);
 
-            if (score >= beta) {
-                return beta;
-            }
-            if (score > alpha) {
-                alpha = score;
-            }
+        if (score >= beta) {
+            return beta;
+        }
+        if (score > alpha) {
+            alpha = score;
         }
     }
     return alpha;
 }
 
 
-// Orders the moves in the given move list
-void Search::orderMoves(Board& b, std::vector<Move>& moveList, std::vector<MoveData>& moveScores, int ply) {
-    int hashKey = b.getZobrist() % TABLE_SIZE;
-    for (Move m : moveList) {
-        MoveData mv = MoveData(0, m);
-        if (b.getTransTable(hashKey).move == m) {
+// Scores and sorts the moves in the given move list
+void Search::orderMoves(Board& b, MoveList& moveList, int ply) {
+    Move hashMove = TT.probe(b.getZobrist()).move;
+    for (ScoredMove& mv : moveList) {
+        Move m = mv.move;
+        if (hashMove == m) {
             mv.score = 100000;
         } else if (m.isCapture()) {
-            mv.score = PieceVals[b.getPiece(m.getTo())] -
-                b.getPiece(m.getFrom());
+            Piece victim = (m.getFlags() == 5 ? nPawn : b.getPiece(m.getTo()));
+            mv.score = PieceVals[victim] - b.getPiece(m.getFrom());
         } else if (ply != -1) {
-            if (m == b.killerMoves[ply][0]) {
+            if (m == killerMoves[ply][0]) {
                 mv.score = 50;
-            } else if (m == b.killerMoves[ply][1]) {
+            } else if (m == killerMoves[ply][1]) {
                 mv.score = 49;
             }
         } else {
             mv.score = 0;
         }
-        moveScores.push_back(mv);
     }
 
-    std::sort(moveScores.begin(), moveScores.end(), sortMoves());
+    std::sort(moveList.begin(), moveList.end(), sortMoves());
 }
\ No newline at end of file
@@ -0,0 +1,434 @@
+#include "sliders.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_BMI2_BUILTINS
+#endif
+
+// Rays each slider moves along
+static constexpr int bishopRays[4] = {2, 3, 6, 7};
+static constexpr int rookRays[4] = {0, 1, 4, 5};
+
+
+// Returns the attacks from the square along the four given rays
+static constexpr unsigned long long slowAttacks(int sq, unsigned long long
+        occupied, const int* rays) {
+    unsigned long long attacks = 0;
+    for (int i = 0; i < 4; i++) {
+        attacks |= slowRayAttacks(sq, occupied, rays[i]);
+    }
+    return attacks;
+}
+
+
+// Returns the rays from every square to the edge of the board
+static constexpr std::array<std::array<unsigned long long, 64>, 8> initRays() {
+    std::array<std::array<unsigned long long, 64>, 8> rays{};
+    for (int dir = 0; dir < 8; dir++) {
+        for (int sq = 0; sq < 64; sq++) {
+            rays[dir][sq] = slowRayAttacks(sq, 0, dir);
+        }
+    }
+    return rays;
+}
+
+
+// Returns the PEXT entries of the slider moving along the given rays, whose
+// attack sets start at the given table index
+static constexpr std::array<PextEntry, 64> initPextEntries(const int* rays, int
+        offset) {
+    std::array<PextEntry, 64> entries{};
+    for (int sq = 0; sq < 64; sq++) {
+        PextEntry& entry = entries[sq];
+        entry.attacks = slowAttacks(sq, 0, rays);
+        entry.offset = offset;
+
+        // the last square of a ray is attacked whether it is occupied or not
+        entry.mask = 0;
+        for (int i = 0; i < 4; i++) {
+            unsigned long long ray = slowRayAttacks(sq, 0, rays[i]);
+            if (ray) {
+                int edge = (rays[i] < 4 ? 63 - std::countl_zero(ray) :
+                        std::countr_zero(ray));
+                entry.mask |= ray & ~(1ULL << edge);
+            }
+        }
+        offset += 1 << std::popcount(entry.mask);
+    }
+    return entries;
+}
+
+
+constexpr std::array<std::array<unsigned long long, 64>, 8> rayBB = initRays();
+constexpr std::array<PextEntry, 64> bishopPext = initPextEntries(bishopRays, 0);
+constexpr std::array<PextEntry, 64> rookPext = initPextEntries(rookRays, 5248);
+
+
+// Returns the attacks from the square along the four given rays, using the
+// finished ray table
+static constexpr unsigned long long fastAttacks(int sq, unsigned long long
+        occupied, const int* rays) {
+    unsigned long long attacks = 0;
+    for (int i = 0; i < 4; i++) {
+        unsigned long long ray = rayBB[rays[i]][sq];
+        unsigned long long blockers = ray & occupied;
+        if (blockers) {
+            ray ^= rayBB[rays[i]][rays[i] < 4 ? std::countr_zero(blockers) : 63 -
+                std::countl_zero(blockers)];
+        }
+        attacks |= ray;
+    }
+    return attacks;
+}
+
+
+// Returns the attacks packed into the low bits, one for each square of the
+// attacks on an empty board, as PEXT would
+static constexpr unsigned short packAttacks(unsigned long long attacks, unsigned
+        long long emptyAttacks) {
+    unsigned short packed = 0;
+    while (attacks) {
+        unsigned long long bit = attacks & -attacks;
+        packed |= 1 << std::popcount(emptyAttacks & (bit - 1));
+        attacks ^= bit;
+    }
+    return packed;
+}
+
+
+// Returns the attack sets of both sliders for every occupancy of their masks,
+// packed into the bits of the attacks on an empty board
+static constexpr std::array<unsigned short, PEXT_TABLE_SIZE> initPextTable() {
+    std::array<unsigned short, PEXT_TABLE_SIZE> table{};
+    for (int sq = 0; sq < 64; sq++) {
+        for (const PextEntry* entry : {&bishopPext[sq], &rookPext[sq]}) {
+            const int* rays = (entry == &bishopPext[sq] ? bishopRays : rookRays);
+            // stepping through the subsets of the mask like this visits them in
+            // the order of their PEXT index
+            unsigned long long occupied = 0;
+            int index = entry->offset;
+            do {
+                table[index++] = packAttacks(fastAttacks(sq, occupied, rays),
+                        entry->attacks);
+                occupied = (occupied - entry->mask) & entry->mask;
+            } while (occupied);
+        }
+    }
+    return table;
+}
+
+
+constexpr std::array<unsigned short, PEXT_TABLE_SIZE> pextAttackTable =
+    initPextTable();
+
+
+// Returns whether the CPU supports the BMI2 instructions
+static bool cpuHasBmi2() {
+#ifdef HAVE_BMI2_BUILTINS
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("bmi2");
+#else
+    return false;
+#endif
+}
+
+
+// Returns the name of the backend the engine was built with
+const char* sliderBackendName() {
+#if defined(USE_PEXT)
+    return "pext";
+#elif defined(USE_SHARED)
+    return "shared";
+#elif defined(USE_PORTABLE)
+    return "portable";
+#else
+    return "magic";
+#endif
+}
+
+
+// Returns whether the CPU can run the backend the engine was built with
+bool sliderBackendSupported() {
+#if defined(USE_PEXT)
+    return cpuHasBmi2();
+#else
+    return true;
+#endif
+}
+
+
+// Receives the benchmark results, so that the lookups can't be optimized away
+static volatile unsigned long long benchSink;
+
+// Holds a square and occupancy to look up attacks for in the benchmark
+struct SliderSample {
+    int sq;
+    unsigned long long occupied;
+};
+
+
+// Returns the combined bishop and rook attacks of the samples, using the magic
+// backend
+static unsigned long long magicLookups(const std::vector<SliderSample>& samples) {
+    unsigned long long sum = 0;
+    for (const SliderSample& s : samples) {
+        sum ^= magicBishopAttacks(s.sq, s.occupied) ^ magicRookAttacks(s.sq,
+                s.occupied);
+    }
+    return sum;
+}
+
+
+// Returns the combined bishop and rook attacks of the samples, using the
+// shared-entry magic backend
+static unsigned long long sharedLookups(const std::vector<SliderSample>&
+        samples) {
+    unsigned long long sum = 0;
+    for (const SliderSample& s : samples) {
+        sum ^= sharedBishopAttacks(s.sq, s.occupied) ^ sharedRookAttacks(s.sq,
+                s.occupied);
+    }
+    return sum;
+}
+
+
+// Returns the combined bishop and rook attacks of the samples, using the
+// portable backend
+static unsigned long long portableLookups(const std::vector<SliderSample>&
+        samples) {
+    unsigned long long sum = 0;
+    for (const SliderSample& s : samples) {
+        sum ^= portableBishopAttacks(s.sq, s.occupied) ^ portableRookAttacks(s.sq,
+                s.occupied);
+    }
+    return sum;
+}
+
+
+#ifdef HAVE_BMI2_BUILTINS
+// Returns the bishop attacks from the square using the PEXT tables. It is
+// compiled for BMI2 whatever the build flags, so it may only be called when the
+// CPU supports it.
+__attribute__((target("bmi2")))
+static unsigned long long pextBishopAttacks(int sq, unsigned long long occupied) {
+    const PextEntry& entry = bishopPext[sq];
+    return _pdep_u64(pextAttackTable[entry.offset + _pext_u64(occupied,
+                entry.mask)], entry.attacks);
+}
+
+
+// Returns the rook attacks from the square using the PEXT tables, with the
+// same restriction as pextBishopAttacks
+__attribute__((target("bmi2")))
+static unsigned long long pextRookAttacks(int sq, unsigned long long occupied) {
+    const PextEntry& entry = rookPext[sq];
+    return _pdep_u64(pextAttackTable[entry.offset + _pext_u64(occupied,
+                entry.mask)], entry.attacks);
+}
+
+
+// Returns the combined bishop and rook attacks of the samples, using the PEXT
+// backend. It is compiled for BMI2 whatever the build flags, so it may only be
+// called when the CPU supports it.
+__attribute__((target("bmi2")))
+static unsigned long long pextLookups(const std::vector<SliderSample>& samples) {
+    unsigned long long sum = 0;
+    for (const SliderSample& s : samples) {
+        sum ^= pextBishopAttacks(s.sq, s.occupied) ^ pextRookAttacks(s.sq,
+                s.occupied);
+    }
+    return sum;
+}
+#endif
+
+
+// Holds the lookups of one backend
+struct SliderBackend {
+    const char* name;
+    // Returns the combined attacks of the samples, timed by the benchmark
+    unsigned long long (*run)(const std::vector<SliderSample>&);
+    unsigned long long (*bishop)(int, unsigned long long);
+    unsigned long long (*rook)(int, unsigned long long);
+    bool supported;
+    size_t bytes;
+};
+
+
+// Returns whether the backend gives the same attacks as stepping along the rays
+// for every sample, and prints the first sample where it does not
+static bool checkBackend(const SliderBackend& backend, const
+        std::vector<SliderSample>& samples) {
+    for (const SliderSample& s : samples) {
+        const char* piece = nullptr;
+        if (backend.bishop(s.sq, s.occupied) != slowAttacks(s.sq, s.occupied,
+                    bishopRays)) {
+            piece = "bishop";
+        } else if (backend.rook(s.sq, s.occupied) != slowAttacks(s.sq,
+                    s.occupied, rookRays)) {
+            piece = "rook";
+        }
+        if (piece) {
+            std::cout << "info string attackbench " << backend.name << " wrong " <<
+                piece << " square " << s.sq << " occupied 0x" << std::hex <<
+                s.occupied << std::dec << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// Counts the L2 accesses or misses of this thread through perf_event_open,
+// where the kernel and CPU allow it. Reads that miss L1 are the L2 accesses,
+// and reads that reach the last level cache the L2 misses.
+class CacheCounter {
+    int fd;
+public:
+    // Opens a counter of the L2 misses, or of the L2 accesses
+    CacheCounter(bool misses) {
+        fd = -1;
+#ifdef __linux__
+        unsigned long long level = (misses ? PERF_COUNT_HW_CACHE_LL :
+                PERF_COUNT_HW_CACHE_L1D);
+        unsigned long long result = (misses ? PERF_COUNT_HW_CACHE_RESULT_ACCESS :
+                PERF_COUNT_HW_CACHE_RESULT_MISS);
+        perf_event_attr attr = {};
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.size = sizeof(attr);
+        attr.config = level | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (result << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+
+    ~CacheCounter() {
+#ifdef __linux__
+        if (fd >= 0) {
+            close(fd);
+        }
+#endif
+    }
+
+    // Returns whether the counter could be opened
+    bool valid() const {
+        return fd >= 0;
+    }
+
+    // Sets the count back to zero
+    void reset() {
+#ifdef __linux__
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        }
+#endif
+    }
+
+    // Starts or stops counting
+    void enable(bool on) {
+#ifdef __linux__
+        if (fd >= 0) {
+            ioctl(fd, on ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, 0);
+        }
+#endif
+    }
+
+    // Returns the events counted so far
+    unsigned long long read() const {
+        unsigned long long count = 0;
+#ifdef __linux__
+        if (fd >= 0 && ::read(fd, &count, sizeof(count)) != sizeof(count)) {
+            count = 0;
+        }
+#endif
+        return count;
+    }
+};
+
+
+// Times each sliding attack backend the CPU can run on random squares and
+// occupancies, and prints their lookups per second, table size and cache
+// misses. With pressure, the given number of megabytes is streamed through
+// between rounds, evicting the tables the way other threads' TT probes do.
+void sliderBench(int lookups, int pressureMB) {
+    // about a quarter of the squares are occupied, as in a middlegame
+    std::mt19937_64 rng(1);
+    std::vector<SliderSample> samples(4096);
+    for (SliderSample& s : samples) {
+        s.sq = rng() % 64;
+        s.occupied = rng() & rng();
+    }
+    int rounds = std::max(lookups / (2 * (int)samples.size()), 1);
+    std::vector<unsigned long long> pressure((size_t)pressureMB << 17);
+
+    std::vector<SliderBackend> backends = {
+        {"magic", magicLookups, magicBishopAttacks, magicRookAttacks, true,
+            (5248 + 102400) * 8},
+        {"shared", sharedLookups, sharedBishopAttacks, sharedRookAttacks, true,
+            (5248 + 102400) + (1428 + 4900) * 8},
+#ifdef HAVE_BMI2_BUILTINS
+        {"pext", pextLookups, pextBishopAttacks, pextRookAttacks, cpuHasBmi2(),
+            PEXT_TABLE_SIZE * 2},
+#endif
+        {"portable", portableLookups, portableBishopAttacks, portableRookAttacks,
+            true, sizeof(rayBB)}
+    };
+
+    CacheCounter l2Accesses(false);
+    CacheCounter l2Misses(true);
+
+    for (const SliderBackend& backend : backends) {
+        if (!backend.supported) {
+            std::cout << "info string attackbench " << backend.name <<
+                " unsupported" << std::endl;
+            continue;
+        }
+
+        unsigned long long sum = 0;
+        std::chrono::duration<double> seconds(0);
+        l2Accesses.reset();
+        l2Misses.reset();
+        for (int r = 0; r < rounds; r++) {
+            for (size_t i = 0; i < pressure.size(); i += 8) {
+                pressure[i]++;
+            }
+            l2Accesses.enable(true);
+            l2Misses.enable(true);
+            auto start = std::chrono::high_resolution_clock::now();
+            sum ^= backend.run(samples);
+            seconds += std::chrono::high_resolution_clock::now() - start;
+            l2Accesses.enable(false);
+            l2Misses.enable(false);
+        }
+
+        bool correct = checkBackend(backend, samples);
+        std::cout << "info string attackbench " << backend.name << " " <<
+            (unsigned long long)(2.0 * rounds * samples.size() / seconds.count()
+                    / 1e6 + 0.5) << " Mlookups/s tables " << backend.bytes / 1024
+            << " kb";
+        if (l2Accesses.valid() && l2Misses.valid()) {
+            unsigned long long accesses = l2Accesses.read();
+            unsigned long long misses = l2Misses.read();
+            std::cout << " l2 accesses " << accesses << " misses " << misses <<
+                " miss rate " << (double)misses / std::max(accesses, 1ULL);
+        } else {
+            std::cout << " cache counters unavailable";
+        }
+        std::cout << (correct ? "" : " wrong") << std::endl;
+        benchSink = sum;
+    }
+    std::cout << "info string attackbench engine uses " << sliderBackendName() <<
+        std::endl;
+}
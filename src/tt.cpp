@@ -0,0 +1,375 @@
+#include "tt.hpp"
+#include "board.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+TransTable TT;
+
+// Size of the header page at the start of a saved table file. The buckets
+// follow it, so they start at an offset that can be mapped.
+const size_t TABLE_FILE_OFFSET = 4096;
+
+// Identifies a saved table file and the format version it was written in
+const char TABLE_FILE_MAGIC[8] = {'C', 'H', 'E', 'S', 'S', 'T', 'T', '1'};
+
+// Holds the header of a saved table file
+struct TableFileHeader {
+    char magic[8];
+    unsigned long long zobrist;
+    unsigned long long buckets;
+    unsigned long long generation;
+};
+
+
+// Packs the fields of an entry into its data word
+static unsigned long long pack(int depth, int score, int eval, HashType nodeType,
+        Move move, unsigned char generation) {
+    unsigned long long data = (move.getFlags() << 12) | (move.getFrom() << 6) |
+        move.getTo();
+    data |= (unsigned long long)(unsigned short)std::clamp(score, -32767, 32767) << 16;
+    data |= (unsigned long long)(unsigned short)std::clamp(eval, -32768, 32767) << 32;
+    data |= (unsigned long long)std::clamp(depth, 0, 255) << 48;
+    data |= (unsigned long long)(nodeType | (generation << 2)) << 56;
+    return data;
+}
+
+
+// Unpacks an entry's data word
+static HashEntry unpack(unsigned long long data) {
+    unsigned int move = data & 0xffff;
+    return HashEntry((data >> 48) & 0xff, (short)(data >> 16), (short)(data >> 32),
+            (HashType)((data >> 56) & 3), Move((move >> 6) & 0x3f, move & 0x3f,
+            move >> 12));
+}
+
+
+// Returns the generation an entry's data word was stored in
+static unsigned char entryGeneration(unsigned long long data) {
+    return data >> 58;
+}
+
+
+// Constructs a new table of the default size
+TransTable::TransTable() {
+    table = nullptr;
+    mask = 0;
+    generation = 0;
+    pageMode = PAGES_NORMAL;
+    resize(16);
+}
+
+
+TransTable::~TransTable() {
+    release();
+}
+
+
+// Returns the table's memory to the system
+void TransTable::release() {
+#ifdef __linux__
+    if (pageMode == PAGES_MAPPED) {
+        munmap(table, (mask + 1) * sizeof(HashBucket));
+        table = nullptr;
+        return;
+    }
+#endif
+    largeFree(table, (mask + 1) * sizeof(HashBucket));
+    table = nullptr;
+}
+
+
+// Resizes the table to the largest power of two number of buckets that fits in
+// the given number of megabytes. The new memory comes zeroed, so it is empty.
+void TransTable::resize(size_t mb) {
+    size_t count = (mb << 20) / sizeof(HashBucket);
+    size_t buckets = 1;
+    while (2 * buckets <= count) {
+        buckets *= 2;
+    }
+
+    release();
+    table = (HashBucket*)largeAlloc(buckets * sizeof(HashBucket), &pageMode);
+    mask = buckets - 1;
+    generation = 0;
+}
+
+
+// Empties every entry of the table
+void TransTable::clear() {
+    for (size_t i = 0; i <= mask; i++) {
+        table[i] = HashBucket();
+    }
+    generation = 0;
+}
+
+
+// Returns the size of the table in megabytes
+size_t TransTable::getSize() const {
+    return ((mask + 1) * sizeof(HashBucket)) >> 20;
+}
+
+
+// Returns the kind of pages backing the table
+PageMode TransTable::getPageMode() const {
+    return pageMode;
+}
+
+
+// Ages the table so entries from previous searches are replaced first
+void TransTable::newSearch() {
+    generation = (generation + 1) & 0x3f;
+}
+
+
+// Returns the entry for the given key, or an empty entry if there is none
+HashEntry TransTable::probe(unsigned long long key) const {
+    const HashBucket& bucket = table[key & mask];
+    for (int i = 0; i < BUCKET_SIZE; i++) {
+        unsigned long long data = bucket.entries[i].data;
+        unsigned long long check = bucket.entries[i].check;
+        if (data != 0 && (check ^ data) == key) {
+            return unpack(data);
+        }
+    }
+    return HashEntry();
+}
+
+
+// Stores a search result. An entry for the same position is always replaced,
+// otherwise the entry with the lowest depth is replaced, counting entries left
+// over from earlier searches as shallower the older they are.
+void TransTable::store(unsigned long long key, int depth, int score, int eval,
+        HashType nodeType, Move move) {
+    HashBucket& bucket = table[key & mask];
+    PackedEntry* replace = &bucket.entries[0];
+    int replaceValue = 0;
+    for (int i = 0; i < BUCKET_SIZE; i++) {
+        PackedEntry* entry = &bucket.entries[i];
+        unsigned long long data = entry->data;
+        if (data == 0 || (entry->check ^ data) == key) {
+            replace = entry;
+            break;
+        }
+        int age = (generation - entryGeneration(data)) & 0x3f;
+        int value = ((data >> 48) & 0xff) - 8 * age;
+        if (i == 0 || value < replaceValue) {
+            replace = entry;
+            replaceValue = value;
+        }
+    }
+    unsigned long long data = pack(depth, score, eval, nodeType, move, generation);
+    replace->check = key ^ data;
+    replace->data = data;
+}
+
+
+// Returns how full the table is with entries of this search, in permill
+int TransTable::hashfull() const {
+    int count = 0;
+    for (size_t i = 0; i < 1000 / BUCKET_SIZE && i <= mask; i++) {
+        for (int j = 0; j < BUCKET_SIZE; j++) {
+            unsigned long long data = table[i].entries[j].data;
+            if (data != 0 && entryGeneration(data) == generation) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+
+
+// Writes the table to the given file, returning whether it succeeded. The
+// header records the Zobrist keys in use, since entries are only valid for the
+// keys they were stored under.
+bool TransTable::save(const std::string& file) const {
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+
+    TableFileHeader header;
+    std::memcpy(header.magic, TABLE_FILE_MAGIC, sizeof(header.magic));
+    header.zobrist = zobristSignature();
+    header.buckets = mask + 1;
+    header.generation = generation;
+
+    char page[TABLE_FILE_OFFSET] = {};
+    std::memcpy(page, &header, sizeof(header));
+    out.write(page, TABLE_FILE_OFFSET);
+    out.write((const char*)table, (mask + 1) * sizeof(HashBucket));
+    return (bool)out;
+}
+
+
+// Replaces the table with one written by save(), returning whether it
+// succeeded. The file is mapped copy-on-write, so entries stored by later
+// searches change the engine's copy but never the file.
+bool TransTable::load(const std::string& file) {
+    std::ifstream in(file, std::ios::binary);
+    TableFileHeader header;
+    if (!in.read((char*)&header, sizeof(header)) ||
+            std::memcmp(header.magic, TABLE_FILE_MAGIC, sizeof(header.magic)) != 0
+            || header.zobrist != zobristSignature() || header.buckets == 0 ||
+            (header.buckets & (header.buckets - 1)) != 0) {
+        return false;
+    }
+    size_t bytes = header.buckets * sizeof(HashBucket);
+
+#ifdef __linux__
+    in.close();
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    void* mem = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= TABLE_FILE_OFFSET + bytes) {
+        mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                TABLE_FILE_OFFSET);
+    }
+    close(fd);
+    if (mem == MAP_FAILED) {
+        return false;
+    }
+    release();
+    table = (HashBucket*)mem;
+    pageMode = PAGES_MAPPED;
+#else
+    PageMode mode;
+    HashBucket* mem = (HashBucket*)largeAlloc(bytes, &mode);
+    in.seekg(TABLE_FILE_OFFSET);
+    if (!in.read((char*)mem, bytes)) {
+        largeFree(mem, bytes);
+        return false;
+    }
+    release();
+    table = mem;
+    pageMode = mode;
+#endif
+
+    mask = header.buckets - 1;
+    generation = header.generation & 0x3f;
+    return true;
+}
+
+
+// Number of buckets the stress test positions share
+const unsigned int STRESS_BUCKETS = 4;
+
+// Returns the key of the stress test position with the given number. The low
+// bits, which index the table, only take STRESS_BUCKETS values, so many
+// positions crowd into a few buckets and keep replacing each other. The number
+// itself is in bits 32 to 47 and a hash of it in the top bits, so a torn key
+// can be told apart from a real one.
+static unsigned long long stressKey(unsigned int i) {
+    return ((0x9E3779B97F4A7C15ULL * (i + 1)) & 0xffff000000000000ULL) |
+        ((unsigned long long)i << 32) | (i % STRESS_BUCKETS);
+}
+
+
+// Returns the number of the stress test position a key claims to be
+static unsigned int stressNumber(unsigned long long key) {
+    return (key >> 32) & 0xffff;
+}
+
+
+// Stores to and reads from a small table with the given number of threads for
+// the given time. Every position is always stored with the same data, but the
+// positions share a few buckets, so a read entry is torn if its words came from
+// writes of different positions. Torn entries whose check word still decodes to
+// a real key are accepted by probe().
+//
+// Without the check word, entries are written with the plain key instead of
+// the key XORed with the data, and read the same way. That run is the control:
+// it shows the test does produce torn reads, which then go unnoticed.
+void TransTable::stressTest(int threads, int ms, bool checkWord) {
+    const unsigned int positions = 256;
+    TransTable table;
+    table.resize(1);
+
+    std::vector<unsigned long long> expected(positions);
+    for (unsigned int i = 0; i < positions; i++) {
+        expected[i] = pack(1 + i % 60, 7 * i % 2000 - 1000, 13 * i % 2000 - 1000,
+                HASH_EXACT, Move(i & 0x3f, (5 * i) & 0x3f, 0), table.generation);
+    }
+
+    std::vector<unsigned long long> reads(threads);
+    std::vector<unsigned long long> detected(threads);
+    std::vector<unsigned long long> accepted(threads);
+    std::vector<std::thread> workers;
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            std::mt19937 rng(t);
+            unsigned long long read = 0;
+            unsigned long long torn = 0;
+            unsigned long long bad = 0;
+            while (std::chrono::steady_clock::now() < end) {
+                for (int n = 0; n < 1000; n++) {
+                    unsigned int i = rng() % positions;
+                    if (checkWord) {
+                        HashEntry entry = unpack(expected[i]);
+                        table.store(stressKey(i), entry.depth, entry.score,
+                                entry.eval, entry.nodeType, entry.move);
+                    } else {
+                        PackedEntry& entry = table.table[stressKey(i) &
+                            table.mask].entries[rng() % BUCKET_SIZE];
+                        entry.check = stressKey(i);
+                        entry.data = expected[i];
+                    }
+
+                    const HashBucket& bucket = table.table[stressKey(rng() %
+                            positions) & table.mask];
+                    for (int j = 0; j < BUCKET_SIZE; j++) {
+                        unsigned long long data = bucket.entries[j].data;
+                        unsigned long long check = bucket.entries[j].check;
+                        if (data == 0) {
+                            continue;
+                        }
+                        read++;
+                        unsigned long long key = (checkWord ? check ^ data :
+                                check);
+                        unsigned int k = stressNumber(key);
+                        if (k >= positions || key != stressKey(k)) {
+                            torn++;
+                        } else if (data != expected[k]) {
+                            bad++;
+                        }
+                    }
+                }
+            }
+            reads[t] = read;
+            detected[t] = torn;
+            accepted[t] = bad;
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    unsigned long long totalReads = 0;
+    unsigned long long totalDetected = 0;
+    unsigned long long totalAccepted = 0;
+    for (int t = 0; t < threads; t++) {
+        totalReads += reads[t];
+        totalDetected += detected[t];
+        totalAccepted += accepted[t];
+    }
+    std::cout << "info string ttstress " << (checkWord ? "check word" :
+            "no check word") << " threads " << threads << " reads " <<
+        totalReads << " torn detected " << totalDetected << " torn accepted " <<
+        totalAccepted << std::endl;
+}
@@ -1,14 +1,82 @@
 
 #include "uci.hpp"
+#include "perft.hpp"
+#include <charconv>
+#include <random>
+#include <unordered_map>
 
 using namespace std;
 
+#ifdef COUNT_ALLOCS
+// Counts the heap allocations made, which bench reports for the search
+atomic<unsigned long long> allocCount(0);
+
+void* operator new(size_t size) {
+    allocCount++;
+    if (void* mem = malloc(size)) {
+        return mem;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* mem) noexcept {
+    free(mem);
+}
+
+void operator delete(void* mem, size_t) noexcept {
+    free(mem);
+}
+#endif
+
+// Positions searched by the bench command
+const string benchPositions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+    "r2q1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP3PPP/R2QKB1R w KQ - 0 9",
+    "2r3k1/pp3ppp/4p3/3pP3/3P4/P4N2/1P3PPP/2R3K1 b - - 0 24",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "8/8/4k3/3p4/3P4/4K3/8/8 w - - 0 1"
+};
+
+// Reads a spin option's value into result, clamped to the option's range.
+// Returns false and leaves result alone if the value is not a whole number.
+static bool parseSpin(const string& value, int min, int max, int& result) {
+    long long parsed;
+    const char* end = value.data() + value.size();
+    auto [ptr, ec] = from_chars(value.data(), end, parsed);
+    if (ec == errc::result_out_of_range) {
+        parsed = (value[0] == '-' ? min : max);
+    } else if (ec != errc() || ptr != end) {
+        return false;
+    }
+    result = (int)std::clamp<long long>(parsed, min, max);
+    return true;
+}
+
+
 UCI::UCI() {
     wtime = 0;
+    threads = 1;
+    pawnTables.resize(threads);
 }
 void UCI::loop() {
     string start = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
-    initBitboards();
+
+    // a build for instructions this CPU lacks would crash on the first lookup,
+    // so it quits before reading any commands
+    if (!sliderBackendSupported()) {
+        cout << "info string this CPU does not support the " <<
+            sliderBackendName() << " backend, build with a different SLIDERS"
+            << endl;
+        return;
+    }
+    if (!bitopsSupported()) {
+        cout << "info string this CPU does not support the " << bitopsName() <<
+            " instructions, build with BITOPS=portable" << endl;
+        return;
+    }
 
     //b.printBoard();
     std::string line;
@@ -22,11 +90,55 @@ void UCI::loop() {
         if (token == "uci") {
             cout << "id name Engine" << endl;
             cout << "id author Brock Grassy" << endl;
+            cout << "option name Hash type spin default 16 min 1 max 65536" << endl;
+            cout << "option name Threads type spin default 1 min 1 max 256" << endl;
+            cout << "option name EvalCache type spin default " <<
+                EVAL_CACHE_DEFAULT_MB << " min 1 max 1024" << endl;
+            cout << "option name LazyMargin type spin default " <<
+                LAZY_MARGIN_DEFAULT << " min 0 max 10000" << endl;
             cout << "uciok" << endl;
+            cout << "info string hash " << TT.getSize() << " MB on " <<
+                pageModeName(TT.getPageMode()) << endl;
+            cout << "info string sliding attacks " << sliderBackendName() << endl;
+            cout << "info string bit instructions " << bitopsName() << endl;
         } else if (token == "isready") {
             cout << "readyok" << endl;
+        } else if (token == "setoption") {
+            string name;
+            string value;
+            is >> token; // name
+            while (is >> token && token != "value") {
+                name += token;
+            }
+            is >> value;
+            // values that are not numbers are ignored
+            int spin;
+            if (name == "Hash" && parseSpin(value, 1, 65536, spin)) {
+                size_t old = std::max(TT.getSize(), (size_t)1);
+                try {
+                    TT.resize(spin);
+                } catch (const bad_alloc&) {
+                    cout << "info string no memory for a " << spin << " MB hash"
+                        << endl;
+                    TT.resize(old);
+                }
+                cout << "info string hash " << TT.getSize() << " MB on " <<
+                    pageModeName(TT.getPageMode()) << endl;
+            } else if (name == "Threads" && parseSpin(value, 1, 256, spin)) {
+                threads = spin;
+                pawnTables.resize(threads);
+            } else if (name == "EvalCache" && parseSpin(value, 1, 1024, spin)) {
+                evalCache.resize(spin);
+            } else if (name == "LazyMargin" && parseSpin(value, 0, 10000, spin)) {
+                lazyMargin = spin;
+            }
         } else if (token == "ucinewgame") {
             b.setPosition(start);
+            TT.clear();
+            evalCache.clear();
+            for (PawnTable& pawnTable : pawnTables) {
+                pawnTable.clear();
+            }
         } else if (token == "position") {
             is >> token;
             if (token == "startpos") {
@@ -41,17 +153,26 @@ void UCI::loop() {
                 b.printBoard();
             }
 
+            // Leave room in the history for the search, which makes at most
+            // MAX_PLY moves and as many again in quiescence
             while (is >> token) {
-                if (token != "moves") { // make move
-                    Move m = stringToMove(token);
-                    b.makeMove(m);
+                if (token == "moves") {
+                    continue;
                 }
+                if (b.getHistoryRoom() <= 2 * MAX_PLY) {
+                    cout << "info string move list too long, ignoring moves "
+                            "from " << token << endl;
+                    break;
+                }
+                Move m = stringToMove(token);
+                b.makeMove(m);
             }
         } else if (token == "go") {
             if (info.stopped) {
                 int max = 9;
+                int perftDepth = 0;
+                int perftHash = 0;
                 info.duration = 0;
-                info.stopped = false;
                 while (is >> token) {
                     if (token == "depth") {
                         is >> max;
@@ -59,14 +180,86 @@ void UCI::loop() {
                         is >> info.duration;
                     } if (token == "infinite") {
                         max = 1000;
+                    } if (token == "perft") {
+                        is >> perftDepth;
+                    } if (token == "hash") {
+                        is >> perftHash;
                     }
                 }
-                thread th1(&UCI::findMove, this, max);
-                th1.detach();
+                if (perftDepth > 0) {
+                    perftDivide(b, perftDepth, std::clamp(perftHash, 0, 65536),
+                            threads);
+                } else {
+                    info.stopped = false;
+                    thread th1(&UCI::findMove, this, max);
+                    th1.detach();
+                }
             }
 
         } else if (token == "stop") {
             info.stopped = true;
+        } else if (token == "bench") {
+            int depth;
+            if (!(is >> depth)) {
+                depth = 7;
+            }
+            bench(depth);
+        } else if (token == "attackbench") {
+            int lookups;
+            int pressureMB;
+            if (!(is >> lookups)) {
+                lookups = 100000000;
+            }
+            if (!(is >> pressureMB)) {
+                pressureMB = 0;
+            }
+            sliderBench(lookups, std::max(pressureMB, 0));
+        } else if (token == "evalbench") {
+            int count;
+            if (!(is >> count)) {
+                count = 1000;
+            }
+            evalBench(count);
+        } else if (token == "pawnbench") {
+            int count;
+            if (!(is >> count)) {
+                count = 10000;
+            }
+            pawnBench(count);
+        } else if (token == "keystats") {
+            int count;
+            if (!(is >> count)) {
+                count = 1000000;
+            }
+            keyStats(count);
+        } else if (token == "savehash") {
+            string file;
+            getline(is >> ws, file);
+            if (TT.save(file)) {
+                cout << "info string saved hash to " << file << endl;
+            } else {
+                cout << "info string could not save hash to " << file << endl;
+            }
+        } else if (token == "loadhash") {
+            string file;
+            getline(is >> ws, file);
+            if (TT.load(file)) {
+                cout << "info string hash " << TT.getSize() << " MB on " <<
+                    pageModeName(TT.getPageMode()) << endl;
+            } else {
+                cout << "info string could not load hash from " << file << endl;
+            }
+        } else if (token == "ttstress") {
+            int count;
+            int ms;
+            if (!(is >> count)) {
+                count = 4;
+            }
+            if (!(is >> ms)) {
+                ms = 5000;
+            }
+            TransTable::stressTest(std::max(count, 1), ms, true);
+            TransTable::stressTest(std::max(count, 1), ms, false);
         } else if (token == "print") {
             b.printBoard();
             cout << endl;
@@ -77,40 +270,78 @@ void UCI::loop() {
 }
 
 void UCI::findMove(int max) {
-    vector<Move> moveList;
     Move bestMove;
-    Search search(&info);
+    Search search(&info, &pawnTables[0]);
+    int completedDepth = 0;
+    int bestScore = 0;
 
-    for (int depth = 1; depth <= max; depth++) {
-        info.startTime = chrono::high_resolution_clock::now();
-        info.nodes = 0;
+    max = std::min(max, MAX_PLY - 1);
+    info.startTime = chrono::high_resolution_clock::now();
+    info.nodes = 0;
+    TT.newSearch();
 
-        vector<Move> moves;
-        vector<MoveData> moveList;
+    // start the helper threads, which share the transposition table with us
+    vector<unique_ptr<SearchThread>> helpers;
+    vector<thread> workers;
+    for (unsigned int i = 1; i < threads; i++) {
+        helpers.push_back(make_unique<SearchThread>(b, info, &pawnTables[i]));
+    }
+    for (unsigned int i = 1; i < threads; i++) {
+        workers.emplace_back(&SearchThread::run, helpers[i - 1].get(), max, i);
+    }
 
-        b.getToMove() == nWhite ? getAllMoves<nWhite>(moves, b) : getAllMoves<nBlack>(moves, b);
-        search.orderMoves(b, moves, moveList, -1);
+    for (int depth = 1; depth <= max; depth++) {
+        MoveList moveList;
+
+        b.getToMove() == nWhite ? getLegalMoves<nWhite>(moveList, b) : getLegalMoves<nBlack>(moveList, b);
+        search.orderMoves(b, moveList, -1);
 
         info.depth = depth;
-        info.nodes = 0;
         int score = search.negamaxRoot(b, depth, -MAX_VALUE, MAX_VALUE);
         bestMove = search.bestMove;
 
         if (info.stopped) {
             break;
         }
+        completedDepth = depth;
+        bestScore = score;
+
+        unsigned long long nodes = info.nodes;
+        for (auto& helper : helpers) {
+            nodes += helper->info.nodes;
+        }
 
         auto time = chrono::high_resolution_clock::now();
         auto dur = time - info.startTime;
-        cout << "info depth " << depth << " nodes " << info.nodes << " score cp ";
-        cout << score << " pv";
+        long ms = chrono::duration_cast<std::chrono::milliseconds>(dur).count();
+        cout << "info depth " << depth << " nodes " << nodes << " time " << ms;
+        cout << " score cp " << score << " pv";
         b.printPV(depth);
-        if (chrono::duration_cast<std::chrono::milliseconds>(dur).count() != 0) {
-            cout << " nps " << (int)(0.5 + info.nodes * 1000.0 /
-                    chrono::duration_cast<std::chrono::milliseconds>(dur).count());
+        if (ms != 0) {
+            cout << " nps " << (unsigned long long)(0.5 + nodes * 1000.0 / ms);
         }
+        cout << " hashfull " << TT.hashfull();
         cout << endl; 
     }
+
+    for (auto& helper : helpers) {
+        helper->info.stopped = true;
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+
+    // take the move of the thread that completed the deepest search
+    for (auto& helper : helpers) {
+        if (helper->completedDepth > completedDepth ||
+                (helper->completedDepth == completedDepth &&
+                 helper->score > bestScore)) {
+            completedDepth = helper->completedDepth;
+            bestScore = helper->score;
+            bestMove = helper->bestMove;
+        }
+    }
+
     b.makeMove(bestMove);
     cout << endl;
     b.printBoard();
@@ -118,14 +349,218 @@ void UCI::findMove(int max) {
     info.stopped = true;
 }
 
+// Searches each bench position to the given depth with an empty table of the
+// current Hash size, and reports the total nodes and the speed of the search.
+// The positions are set up on a board of their own, so the one the GUI set up
+// is left alone, and the depth is limited to what the search can reach.
+void UCI::bench(int depth) {
+    Board board;
+    depth = std::clamp(depth, 1, MAX_PLY - 1);
+    unsigned long long nodes = 0;
+    unsigned long long generated = 0;
+    unsigned long long cutoffs[STAGE_DONE] = {};
+    unsigned long long qEvals = 0;
+    unsigned long long lazyEvals = 0;
+    unsigned long long cacheProbes = 0;
+    unsigned long long cacheHits = 0;
+    long ms = 0;
+#ifdef COUNT_ALLOCS
+    unsigned long long allocs = 0;
+#endif
+
+    PawnTable pawnTable;
+    for (const string& fen : benchPositions) {
+        board.setPosition(fen);
+        TT.clear();
+        evalCache.clear();
+
+        SearchInfo benchInfo;
+        benchInfo.stopped = false;
+        Search search(&benchInfo, &pawnTable);
+#ifdef COUNT_ALLOCS
+        unsigned long long startAllocs = allocCount;
+#endif
+        auto start = chrono::high_resolution_clock::now();
+        for (int d = 1; d <= depth; d++) {
+            benchInfo.depth = d;
+            search.negamaxRoot(board, d, -MAX_VALUE, MAX_VALUE);
+        }
+        auto dur = chrono::high_resolution_clock::now() - start;
+#ifdef COUNT_ALLOCS
+        allocs += allocCount - startAllocs;
+#endif
+        ms += chrono::duration_cast<std::chrono::milliseconds>(dur).count();
+        nodes += benchInfo.nodes;
+        generated += benchInfo.generated;
+        for (int stage = 0; stage < STAGE_DONE; stage++) {
+            cutoffs[stage] += benchInfo.cutoffs[stage];
+        }
+        qEvals += benchInfo.qEvals;
+        lazyEvals += benchInfo.lazyEvals;
+        cacheProbes += benchInfo.cacheProbes;
+        cacheHits += benchInfo.cacheHits;
+    }
+
+    cout << "info string bench nodes " << nodes << " time " << ms << " nps " <<
+        (unsigned long long)(0.5 + nodes * 1000.0 / std::max(ms, 1L)) << endl;
+    cout << "info string bench generated " << generated << " per node " <<
+        (double)generated / std::max(nodes, 1ULL) << " cutoffs tt " <<
+        cutoffs[STAGE_TT] << " captures " << cutoffs[STAGE_GOOD_CAPTURES] <<
+        " killers " << cutoffs[STAGE_KILLERS] << " quiets " <<
+        cutoffs[STAGE_QUIETS] << " losing " << cutoffs[STAGE_BAD_CAPTURES] << endl;
+    cout << "info string bench quiescence evals " << qEvals << " lazy " <<
+        lazyEvals << " rate " << 100.0 * lazyEvals / std::max(qEvals, 1ULL) <<
+        "% margin " << lazyMargin << endl;
+    cout << "info string bench eval cache probes " << cacheProbes << " hits " <<
+        cacheHits << " rate " << 100.0 * cacheHits / std::max(cacheProbes, 1ULL) <<
+        "% size " << evalCache.getSize() << " MB" << endl;
+    cout << "info string bench pawn hash probes " << pawnTable.getProbes() <<
+        " hits " << pawnTable.getHits() << " rate " << 100.0 *
+        pawnTable.getHits() / std::max(pawnTable.getProbes(), 1ULL) << "%" << endl;
+#ifdef COUNT_ALLOCS
+    cout << "info string bench allocations " << allocs << endl;
+#endif
+}
+
+
+// Plays random games from the bench positions until the given number of
+// distinct positions is reached. Reports how many of them share a Zobrist key
+// with a different position, and how many incrementally updated keys differ
+// from the key computed from scratch.
+void UCI::keyStats(int count) {
+    Board board;
+    mt19937 rng(1);
+    unordered_map<unsigned long long, string> seen;
+    Board fresh;
+    unsigned long long positions = 0;
+    unsigned long long collisions = 0;
+    unsigned long long mismatches = 0;
+
+    while (seen.size() < (size_t)count) {
+        board.setPosition(benchPositions[rng() % size(benchPositions)]);
+        for (int ply = 0; ply < 200 && seen.size() < (size_t)count; ply++) {
+            MoveList moves;
+            board.getToMove() == nWhite ? getLegalMoves<nWhite>(moves, board) :
+                getLegalMoves<nBlack>(moves, board);
+            if (moves.empty()) {
+                break;
+            }
+            board.makeMove(moves[rng() % moves.size()].move);
+            positions++;
+
+            // the key covers everything up to the move counters
+            string fen = board.getFEN();
+            fen = fen.substr(0, fen.rfind(' ', fen.rfind(' ') - 1));
+            auto it = seen.emplace(board.getZobrist(), fen).first;
+            if (it->second != fen) {
+                collisions++;
+            }
+            fresh.setPosition(fen);
+            if (fresh.getZobrist() != board.getZobrist()) {
+                mismatches++;
+            }
+        }
+    }
+
+    cout << "info string keystats positions " << positions << " distinct " <<
+        seen.size() << " collisions " << collisions << " mismatches " <<
+        mismatches << endl;
+}
+
+
+// Returns the positions of random games played on the board from the bench
+// positions, the same ones on every call
+static vector<string> randomGamePositions(Board& b) {
+    mt19937 rng(1);
+    vector<string> fens;
+    for (const string& fen : benchPositions) {
+        b.setPosition(fen);
+        for (int ply = 0; ply < 100; ply++) {
+            fens.push_back(b.getFEN());
+            MoveList moves;
+            b.getToMove() == nWhite ? getLegalMoves<nWhite>(moves, b) :
+                getLegalMoves<nBlack>(moves, b);
+            if (moves.empty()) {
+                break;
+            }
+            b.makeMove(moves[rng() % moves.size()].move);
+        }
+    }
+    return fens;
+}
+
+
+// Plays random games from the bench positions to collect positions, then times
+// how fast the static evaluation and the legal move generator run over them
+void UCI::evalBench(int repeats) {
+    Board board;
+    vector<string> fens = randomGamePositions(board);
+    PawnTable pawnTable;
+
+    long long sum = 0;
+    unsigned long long calls = 0;
+    chrono::duration<double> evalTime(0);
+    chrono::duration<double> genTime(0);
+    for (const string& fen : fens) {
+        board.setPosition(fen);
+        auto start = chrono::high_resolution_clock::now();
+        for (int i = 0; i < repeats; i++) {
+            sum += board.boardScore(pawnTable);
+        }
+        auto mid = chrono::high_resolution_clock::now();
+        for (int i = 0; i < repeats; i++) {
+            MoveList moves;
+            board.getToMove() == nWhite ? getLegalMoves<nWhite>(moves, board) :
+                getLegalMoves<nBlack>(moves, board);
+            sum += moves.size();
+        }
+        evalTime += mid - start;
+        genTime += chrono::high_resolution_clock::now() - mid;
+        calls += repeats;
+    }
+
+    cout << "info string evalbench positions " << fens.size() << " evals/s " <<
+        (unsigned long long)(calls / std::max(evalTime.count(), 1e-9)) <<
+        " movegen/s " << (unsigned long long)(calls / std::max(genTime.count(),
+                    1e-9)) << " checksum " << sum << endl;
+}
+
+
+// Times the pawn evaluation over the positions of random games, bypassing the
+// pawn table, and reports the nanoseconds it takes per position
+void UCI::pawnBench(int repeats) {
+    Board board;
+    vector<string> fens = randomGamePositions(board);
+    long long sum = 0;
+    unsigned long long calls = 0;
+    chrono::duration<double> pawnTime(0);
+    for (const string& fen : fens) {
+        board.setPosition(fen);
+        PawnEntry entry;
+        auto start = chrono::high_resolution_clock::now();
+        for (int i = 0; i < repeats; i++) {
+            board.evalPawns(entry);
+            sum += entry.score + popcount(entry.passers[nWhite]) -
+                popcount(entry.passers[nBlack]);
+        }
+        pawnTime += chrono::high_resolution_clock::now() - start;
+        calls += repeats;
+    }
+
+    cout << "info string pawnbench positions " << fens.size() << " ns/position "
+        << pawnTime.count() * 1e9 / std::max(calls, 1ULL) << " checksum " << sum
+        << endl;
+}
+
+
 Move UCI::stringToMove(string s) {
-    vector<Move> moveList;     
-    b.getToMove() == nWhite ? getAllMoves<nWhite>(moveList, b) :
-        getAllMoves<nBlack>(moveList, b);
+    MoveList moveList;
+    b.getToMove() == nWhite ? getLegalMoves<nWhite>(moveList, b) :
+        getLegalMoves<nBlack>(moveList, b);
 
-    for (Move m : moveList) {
-        if (s == m.toStr()) {
-            return m;
+    for (ScoredMove& sm : moveList) {
+        if (s == sm.move.toStr()) {
+            return sm.move;
         }
     }
     cout << "INVALID" << endl;
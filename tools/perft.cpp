@@ -0,0 +1,136 @@
+#include "board.hpp"
+#include "perft.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+// Positions with known perft counts, from the chess programming wiki
+struct PerftPosition {
+    const char* fen;
+    int depth;
+    unsigned long long nodes;
+};
+
+const PerftPosition perftSuite[] = {
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 6, 119060324},
+    {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 5,
+        193690690},
+    {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6, 11030083},
+    {"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5,
+        15833292},
+    {"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 5, 89941194},
+    {"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        5, 164075551}
+};
+
+// Runs every suite position to its depth and reports any count that differs
+// from the known one. Returns the number of differences.
+int runSuite(int hashMB, int threads) {
+    int failures = 0;
+    unsigned long long total = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (const PerftPosition& pos : perftSuite) {
+        Board b(pos.fen);
+        PerftTable table(hashMB);
+        std::vector<unsigned long long> rootCounts;
+        unsigned long long nodes = parallelPerft(b, pos.depth, threads, hashMB >
+                0 ? &table : nullptr, rootCounts);
+        total += nodes;
+        std::cout << pos.fen << " depth " << pos.depth << " nodes " << nodes;
+        if (nodes != pos.nodes) {
+            std::cout << " expected " << pos.nodes;
+            failures++;
+        }
+        std::cout << std::endl;
+    }
+
+    auto dur = std::chrono::high_resolution_clock::now() - start;
+    long ms = std::chrono::duration_cast<std::chrono::milliseconds>(dur).count();
+    std::cout << "nodes " << total << " time " << ms << " nps " <<
+        (unsigned long long)(0.5 + total * 1000.0 / std::max(ms, 1L)) <<
+        " failures " << failures << std::endl;
+    return failures;
+}
+
+
+// Runs perft on the position with 1, 2, 4 and so on up to the given number of
+// threads, and reports the speedup of each over one thread. Every run has to
+// reach the same total.
+int runScaling(const std::string& fen, int depth, int hashMB, int maxThreads) {
+    double baseMs = 0;
+    unsigned long long expected = 0;
+    int failures = 0;
+
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        Board b(fen);
+        PerftTable table(hashMB);
+        std::vector<unsigned long long> rootCounts;
+        auto start = std::chrono::high_resolution_clock::now();
+        unsigned long long nodes = parallelPerft(b, depth, threads, hashMB > 0 ?
+                &table : nullptr, rootCounts);
+        auto dur = std::chrono::high_resolution_clock::now() - start;
+        double ms = std::chrono::duration<double, std::milli>(dur).count();
+
+        if (threads == 1) {
+            baseMs = ms;
+            expected = nodes;
+        }
+        std::cout << "threads " << threads << " nodes " << nodes << " time " <<
+            (long)ms << " nps " << (unsigned long long)(0.5 + nodes * 1000.0 /
+                    std::max(ms, 1.0)) << " speedup " << baseMs / std::max(ms,
+                        1.0);
+        if (nodes != expected) {
+            std::cout << " expected " << expected;
+            failures++;
+        }
+        std::cout << std::endl;
+    }
+    return failures;
+}
+
+
+// Usage: perft [-H mb] [-t threads] [-scale] [depth [fen]]
+//
+// Without a depth, runs the suite of known positions. With one, prints the
+// divide counts of the given position, or the starting position. With -scale,
+// times the position on 1 thread and every power of two up to the given number
+// of threads instead.
+int main(int argc, char** argv) {
+    if (!sliderBackendSupported()) {
+        std::cerr << "this CPU does not support the " << sliderBackendName() <<
+            " sliding attack backend" << std::endl;
+        return 2;
+    }
+
+    int hashMB = 0;
+    int threads = 1;
+    bool scale = false;
+    int arg = 1;
+    while (arg < argc && argv[arg][0] == '-') {
+        if (strcmp(argv[arg], "-H") == 0 && arg + 1 < argc) {
+            hashMB = atoi(argv[++arg]);
+        } else if (strcmp(argv[arg], "-t") == 0 && arg + 1 < argc) {
+            threads = std::max(atoi(argv[++arg]), 1);
+        } else if (strcmp(argv[arg], "-scale") == 0) {
+            scale = true;
+        }
+        arg++;
+    }
+
+    if (arg >= argc) {
+        return runSuite(hashMB, threads) == 0 ? 0 : 1;
+    }
+
+    int depth = std::max(atoi(argv[arg++]), 1);
+    std::string fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    if (arg < argc) {
+        fen = argv[arg];
+    }
+    if (scale) {
+        return runScaling(fen, depth, hashMB, threads) == 0 ? 0 : 1;
+    }
+    Board b(fen);
+    perftDivide(b, depth, hashMB, threads);
+    return 0;
+}
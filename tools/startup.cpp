@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+// Starts the engine, sends it uci and returns the microseconds from starting
+// the process until it answers uciok, or -1 if it never does
+static long startEngine(const char* engine) {
+    int toEngine[2];
+    int fromEngine[2];
+    if (pipe(toEngine) != 0 || pipe(fromEngine) != 0) {
+        return -1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(toEngine[0], STDIN_FILENO);
+        dup2(fromEngine[1], STDOUT_FILENO);
+        close(toEngine[1]);
+        close(fromEngine[0]);
+        execl(engine, engine, (char*)nullptr);
+        _exit(127);
+    }
+    close(toEngine[0]);
+    close(fromEngine[1]);
+
+    const char uci[] = "uci\n";
+    long micros = -1;
+    if (write(toEngine[1], uci, strlen(uci)) == (ssize_t)strlen(uci)) {
+        std::string output;
+        char buffer[4096];
+        ssize_t n;
+        while ((n = read(fromEngine[0], buffer, sizeof(buffer))) > 0) {
+            output.append(buffer, n);
+            if (output.find("uciok") != std::string::npos) {
+                auto dur = std::chrono::steady_clock::now() - start;
+                micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                        dur).count();
+                break;
+            }
+        }
+    }
+
+    const char quit[] = "quit\n";
+    if (write(toEngine[1], quit, strlen(quit)) < 0) {
+        kill(pid, SIGKILL);
+    }
+    close(toEngine[1]);
+    close(fromEngine[0]);
+    waitpid(pid, nullptr, 0);
+    return micros;
+}
+
+
+// Usage: startup [-n runs] [engine]
+//
+// Starts the engine, ./chess by default, the given number of times and prints
+// the time from process start until uciok, as analysis jobs that start many
+// short-lived engines see it.
+int main(int argc, char** argv) {
+    int runs = 100;
+    const char* engine = "./chess";
+    int arg = 1;
+    while (arg < argc && argv[arg][0] == '-') {
+        if (strcmp(argv[arg], "-n") == 0 && arg + 1 < argc) {
+            runs = std::max(atoi(argv[++arg]), 1);
+        }
+        arg++;
+    }
+    if (arg < argc) {
+        engine = argv[arg];
+    }
+
+    std::vector<long> times;
+    for (int i = 0; i < runs; i++) {
+        long micros = startEngine(engine);
+        if (micros < 0) {
+            std::cerr << engine << " did not answer uciok" << std::endl;
+            return 1;
+        }
+        times.push_back(micros);
+    }
+
+    std::sort(times.begin(), times.end());
+    long total = 0;
+    for (long t : times) {
+        total += t;
+    }
+    std::cout << engine << " runs " << runs << " uciok us min " << times[0] <<
+        " median " << times[runs / 2] << " mean " << total / runs << " max " <<
+        times[runs - 1] << std::endl;
+    return 0;
+}